@@ -0,0 +1,85 @@
+/*
+ * Compares checksumming a big buffer with CRC-32 (slice-by-8) on one thread
+ * against splitting it into chunks, checksumming them on worker threads and
+ * merging the results with Crc::combine.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "mcu_safe_crc.h"
+
+using namespace safearray;
+
+typedef Crc32::WithPolicy<CrcSliceBy8> FastCrc32;
+
+static const size_t SIZE = 64 << 20;
+static const int REPS = 5;
+
+static ByteArray<SIZE> g_image = {};
+static volatile FastCrc32::value_type g_sink;
+
+static FastCrc32::value_type crcOf(CByteArrayPtr data) {
+    FastCrc32 crc;
+    crc.update(data);
+    return crc.value();
+}
+
+static FastCrc32::value_type parallelCrc(unsigned threads) {
+    std::vector<FastCrc32::value_type> crcs(threads);
+    std::vector<std::thread> workers;
+    size_t chunk = SIZE / threads;
+    for (unsigned t = 0; t < threads; ++t) {
+        size_t start = t * chunk;
+        size_t len = t + 1 == threads ? SIZE - start : chunk;
+        workers.emplace_back([&crcs, t, start, len]() {
+            crcs[t] = crcOf(CByteArrayPtr(g_image.cdata() + start, len));
+        });
+    }
+    for (std::thread& w : workers) {
+        w.join();
+    }
+    FastCrc32::value_type crc = crcs[0];
+    for (unsigned t = 1; t < threads; ++t) {
+        size_t len = t + 1 == threads ? SIZE - t * chunk : chunk;
+        crc = FastCrc32::combine(crc, crcs[t], len);
+    }
+    return crc;
+}
+
+template<typename F>
+static double mbPerSec(F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < REPS; ++r) {
+        f();
+        __asm__ __volatile__("" ::: "memory");
+    }
+    std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+    return (double) SIZE * REPS / d.count() / (1 << 20);
+}
+
+int main() {
+    for (size_t i = 0; i < SIZE; ++i) {
+        g_image[i] = (unsigned char) (i * 2654435761u >> 13);
+    }
+
+    FastCrc32::value_type expected = crcOf(&g_image);
+    double single = mbPerSec([]() { g_sink = crcOf(&g_image); });
+    printf("CRC-32 of %zu MiB\n", SIZE >> 20);
+    printf("%-10s %10s %8s\n", "threads", "MiB/s", "speedup");
+    printf("%-10s %10.0f %8.2f\n", "single", single, 1.0);
+
+    unsigned cores = std::thread::hardware_concurrency();
+    cores = cores == 0 ? 1 : cores;
+    for (unsigned threads = 1; threads <= 2 * cores; threads *= 2) {
+        if (parallelCrc(threads) != expected) {
+            printf("mismatch with %u threads\n", threads);
+            return 1;
+        }
+        double rate = mbPerSec([threads]() { g_sink = parallelCrc(threads); });
+        printf("%-10u %10.0f %8.2f\n", threads, rate, rate / single);
+    }
+    return 0;
+}
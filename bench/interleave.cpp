@@ -0,0 +1,98 @@
+/*
+ * Compares safearray::interleave/deinterleave against the naive loop, for
+ * 16-bit samples with 2, 3 and 4 channels.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "mcu_safe_interleave.h"
+
+using namespace safearray;
+
+static const size_t FRAMES = 4096;
+static const int REPS = 20000;
+
+template<size_t C>
+static void naiveDeinterleave(const int16_t *src, int16_t *const *dest, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t c = 0; c < C; ++c) {
+            dest[c][i] = src[i * C + c];
+        }
+    }
+}
+
+template<typename F>
+static double nsPerFrame(F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < REPS; ++r) {
+        f();
+        __asm__ __volatile__("" ::: "memory");
+    }
+    std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - start;
+    return d.count() / REPS / FRAMES;
+}
+
+static Array<int16_t, 4 * FRAMES> g_src = {};
+static Array<int16_t, FRAMES> g_ch[4] = {};
+
+template<size_t C>
+static void deinterleaveC();
+
+template<>
+void deinterleaveC<2>() {
+    deinterleave(g_src.cslice<0, 2 * FRAMES>(), g_ch[0].slice(), g_ch[1].slice());
+}
+
+template<>
+void deinterleaveC<3>() {
+    deinterleave(g_src.cslice<0, 3 * FRAMES>(), g_ch[0].slice(), g_ch[1].slice(),
+        g_ch[2].slice());
+}
+
+template<>
+void deinterleaveC<4>() {
+    deinterleave(g_src.cslice(), g_ch[0].slice(), g_ch[1].slice(), g_ch[2].slice(),
+        g_ch[3].slice());
+}
+
+template<size_t C>
+static void interleaveC();
+
+template<>
+void interleaveC<2>() {
+    interleave(g_src.slice<0, 2 * FRAMES>(), g_ch[0].cslice(), g_ch[1].cslice());
+}
+
+template<>
+void interleaveC<3>() {
+    interleave(g_src.slice<0, 3 * FRAMES>(), g_ch[0].cslice(), g_ch[1].cslice(),
+        g_ch[2].cslice());
+}
+
+template<>
+void interleaveC<4>() {
+    interleave(g_src.slice(), g_ch[0].cslice(), g_ch[1].cslice(), g_ch[2].cslice(),
+        g_ch[3].cslice());
+}
+
+template<size_t C>
+static void run() {
+    int16_t *dest[4] = { g_ch[0].data(), g_ch[1].data(), g_ch[2].data(), g_ch[3].data() };
+    double naive = nsPerFrame([&] { naiveDeinterleave<C>(g_src.cdata(), dest, FRAMES); });
+    double kernel = nsPerFrame(deinterleaveC<C>);
+    double inter = nsPerFrame(interleaveC<C>);
+    printf("%zu channels: naive deinterleave %.3f ns/frame, deinterleave %.3f ns/frame "
+        "(%.1fx), interleave %.3f ns/frame\n", C, naive, kernel, naive / kernel, inter);
+}
+
+int main() {
+    for (size_t i = 0; i < g_src.size(); ++i) {
+        g_src[i] = (int16_t) rand();
+    }
+    run<2>();
+    run<3>();
+    run<4>();
+    return 0;
+}
@@ -20,6 +20,57 @@
  * 
  * <li>\c safearray::CArrayPtr: A pointer to a const C array with a size known at runtime.
  * This is really just a way to pass a C array and its size in one object.</li>
+ * 
+ * <li>\c safearray::StridedSlice and \c safearray::CStridedSlice: Like
+ * \c %safearray::Slice, but pointing to evenly-spaced elements.</li>
+ * 
+ * <li>\c safearray::ReversedSlice and \c safearray::CReversedSlice: Like
+ * \c %safearray::Slice, but visiting the elements in reverse order.</li>
+ * </ul>
+ *
+ * Other headers build on these:
+ * <ul>
+ * <li>\c mcu_safe_vector.h: \c safearray::StaticVector, a variable-length
+ * collection with a capacity known at compile-time.</li>
+ * <li>\c mcu_safe_string.h: \c safearray::FixedString, a string with a
+ * capacity known at compile-time and printf-free number formatting.</li>
+ * <li>\c mcu_safe_bits.h: \c safearray::BitArray, an array of bits packed
+ * into words, and bit slices of it; \c safearray::BitReader and
+ * \c safearray::BitWriter for fields packed across byte boundaries.</li>
+ * <li>\c mcu_safe_array2d.h: \c safearray::Array2D, a row-major matrix with
+ * row, column and block views.</li>
+ * <li>\c mcu_safe_interleave.h: \c safearray::interleave and
+ * \c safearray::deinterleave for multi-channel samples.</li>
+ * <li>\c mcu_safe_gather.h: \c safearray::GatherList, a list of byte
+ * segments that can be written out without copying them together.</li>
+ * <li>\c mcu_safe_packet.h: \c safearray::PacketBuffer, a packet buffer with
+ * headroom so that protocol layers can prepend headers in place.</li>
+ * <li>\c mcu_safe_checksum.h and \c mcu_safe_crc.h: Fletcher, Adler and CRC
+ * checksums, which can be computed while copying; CRCs use tables generated
+ * at compile-time.</li>
+ * <li>\c mcu_safe_sha256.h: \c safearray::Sha256 and
+ * \c safearray::HmacSha256, streaming hashes with no buffers outside the
+ * object.</li>
+ * <li>\c mcu_safe_framing.h: COBS and SLIP encoding, with buffers sized at
+ * compile-time, and byte-at-a-time decoders.</li>
+ * <li>\c mcu_safe_search.h: finding and counting delimiters and sync words in
+ * byte slices, a vector or a word at a time.</li>
+ * <li>\c mcu_safe_tokenize.h: splitting text into fields that point into the
+ * original buffer.</li>
+ * <li>\c mcu_safe_parse.h: parsing integers and fixed-point numbers from text,
+ * with error codes instead of \c errno.</li>
+ * <li>\c mcu_safe_varint.h: \c safearray::VarintWriter and
+ * \c safearray::VarintReader, for LEB128 varints and zig-zag encoding.</li>
+ * <li>\c mcu_safe_cbor.h: \c safearray::CborWriter, CBOR encoding whose
+ * worst-case size is checked at compile-time.</li>
+ * <li>\c mcu_safe_encoding.h: hex and Base64 encoding and decoding, with
+ * output sizes checked at compile-time.</li>
+ * <li>\c mcu_safe_sort.h: \c safearray::sort, sorting networks for short
+ * slices and introsort for long ones, and \c safearray::nthElement.</li>
+ * <li>\c mcu_safe_filter.h: \c safearray::MedianFilter, a median or
+ * percentile filter over a sliding window.</li>
+ * <li>\c mcu_safe_dsp.h: Q15 and Q31 dot products, FIR and biquad filters,
+ * and moving averages.</li>
  * </ul>
  * 
  * Here's an example of using \c %safearray::Array to parse messages received over a network.
@@ -99,8 +150,35 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#endif
+
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<span>)
+#include <span>
+#define SAFEARRAY_HAVE_SPAN
+#endif
+#endif
+
+/*
+ * Lookup tables marked with SAFEARRAY_PROGMEM are kept in flash on AVR,
+ * and must be read with SAFEARRAY_READ_PROGMEM_BYTE (or
+ * SAFEARRAY_READ_PROGMEM_DWORD for tables of uint32_t).
+ */
+#ifdef __AVR__
+#define SAFEARRAY_PROGMEM PROGMEM
+#define SAFEARRAY_READ_PROGMEM_BYTE(p) pgm_read_byte(p)
+#define SAFEARRAY_READ_PROGMEM_DWORD(p) pgm_read_dword(p)
+#else
+#define SAFEARRAY_PROGMEM
+#define SAFEARRAY_READ_PROGMEM_BYTE(p) (*(const uint8_t *) (p))
+#define SAFEARRAY_READ_PROGMEM_DWORD(p) (*(const uint32_t *) (p))
+#endif
+
 #define SLICE_METH_ASSERTS() \
     do { \
         static_assert(Start <= L, "Bad start index"); \
@@ -113,8 +191,154 @@
         static_assert(Offset < L, "Bad offset"); \
     } while (false);
 
+#define STRIDED_METH_ASSERTS() \
+    do { \
+        static_assert(Stride > 0, "Bad stride"); \
+        static_assert(Start < L, "Bad start index"); \
+    } while (false);
+
 namespace safearray {
 
+template<typename T, size_t L, size_t Stride> class CStridedSlice;
+template<typename T, size_t L, size_t Stride> class StridedSlice;
+template<typename T, size_t L> class CReversedSlice;
+template<typename T, size_t L> class ReversedSlice;
+
+namespace detail {
+
+/**
+ * Copy elements one at a time between any two views with static sizes.
+ * Used where \c memcpy can't be, e.g., for strided or reversed slices.
+ */
+template<typename Dest, typename Src>
+void assignElems(Dest& dest, const Src& src) {
+    static_assert(Src::size() <= Dest::size(), "Bad slice length");
+    for (size_t i = 0; i < Src::size(); ++i) {
+        dest[i] = src[i];
+    }
+}
+
+/**
+ * Compare elements one at a time between any two views with static sizes.
+ */
+template<typename A, typename B>
+bool equalElems(const A& a, const B& b) {
+    static_assert(A::size() == B::size(), "Bad slice length");
+    for (size_t i = 0; i < A::size(); ++i) {
+        if (!(a[i] == b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Rotations that would move at most this many bytes through a temporary
+ * buffer on the stack use one; longer ones are done in place by reversing.
+ */
+constexpr size_t ROTATE_BUFFER_BYTES = 32;
+
+template<typename T>
+void reverseElems(T *data, size_t n) {
+    for (size_t i = 0, j = n; i + 1 < j; ++i) {
+        --j;
+        T tmp = data[i];
+        data[i] = data[j];
+        data[j] = tmp;
+    }
+}
+
+/**
+ * Rotate \c L elements left by \c N, i.e., so that element \c N becomes
+ * element \c 0.
+ */
+template<typename T, size_t L, size_t N,
+    bool Buffered = (N <= L - N ? N : L - N) * sizeof(T) <= ROTATE_BUFFER_BYTES>
+struct Rotate {
+    static void run(T *data) {
+        reverseElems(data, N);
+        reverseElems(data + N, L - N);
+        reverseElems(data, L);
+    }
+};
+
+template<typename T, size_t L, size_t N>
+struct Rotate<T, L, N, true> {
+    static constexpr size_t K = N <= L - N ? N : L - N;
+
+    static void run(T *data) {
+        if (K == 0) {
+            return;
+        }
+        T tmp[K == 0 ? 1 : K];
+        if (N <= L - N) {
+            memcpy(tmp, data, N * sizeof(T));
+            memmove(data, data + N, (L - N) * sizeof(T));
+            memcpy(data + L - N, tmp, N * sizeof(T));
+        } else {
+            memcpy(tmp, data + N, (L - N) * sizeof(T));
+            memmove(data + L - N, data, N * sizeof(T));
+            memcpy(data, tmp, (L - N) * sizeof(T));
+        }
+    }
+};
+
+/**
+ * The number of elements of an \c L -element array that are selected by
+ * starting at \c Start and taking every \c Stride th one.
+ */
+constexpr size_t stridedSize(size_t L, size_t Start, size_t Stride) {
+    return Start >= L || Stride == 0 ? 0 : (L - Start + Stride - 1) / Stride;
+}
+
+#if __cplusplus >= 202002L
+/**
+ * An empty member that makes its owner non-copyable.  Since C++20, a class
+ * with user-declared (even deleted) constructors isn't an aggregate, so
+ * \c Array uses this instead of deleting its copy constructors.
+ */
+struct NonCopyable {
+    NonCopyable() = default;
+    NonCopyable(const NonCopyable&) = delete;
+    NonCopyable& operator=(const NonCopyable&) = delete;
+};
+#endif
+
+template<size_t... Is>
+struct Indices {
+    typedef Indices type;
+};
+
+template<typename A, typename B>
+struct ConcatIndices;
+
+template<size_t... As, size_t... Bs>
+struct ConcatIndices<Indices<As...>, Indices<Bs...> >
+    : Indices<As..., (sizeof...(As) + Bs)...> {};
+
+/**
+ * <tt>Indices<0, 1, ..., N - 1></tt>, built by halving so that big tables
+ * don't hit the compiler's template recursion limit.
+ */
+template<size_t N>
+struct MakeIndices
+    : ConcatIndices<typename MakeIndices<N / 2>::type,
+                    typename MakeIndices<N - N / 2>::type>::type {};
+
+template<> struct MakeIndices<0> : Indices<> {};
+template<> struct MakeIndices<1> : Indices<0> {};
+
+constexpr size_t sum() {
+    return 0;
+}
+
+template<typename... Ls>
+constexpr size_t sum(size_t l, Ls... ls) {
+    return l + sum(ls...);
+}
+
+} // namespace detail
+
 /**
  * \brief A pointer to a const C array with a size known at runtime.
  * 
@@ -154,6 +378,24 @@ public:
         return this->_data;
     }
 
+    /**
+     * \brief Get an iterator to the first element.
+     *
+     * \return A pointer to the first element.
+     */
+    const T *begin() const {
+        return this->_data;
+    }
+
+    /**
+     * \brief Get an iterator to just past the last element.
+     *
+     * \return A pointer to just past the last element.
+     */
+    const T *end() const {
+        return this->_data + this->_size;
+    }
+
 private:
     const T *_data;
     size_t _size;
@@ -251,6 +493,55 @@ public:
         return CSlice<T, End - Start>(this->cdata<Start>());
     }
 
+    /**
+     * \brief Make a slice pointing to every \c Stride th element.
+     *
+     * The params are statically checked to ensure memory-safety.
+     *
+     * \tparam Stride The distance between consecutive elements of the new
+     * slice.
+     * \tparam Start The index of the first element of the new slice.
+     * Default: \c 0.
+     *
+     * \return A slice pointing to the elements at indices \c Start,
+     * \c Start \c + \c Stride, \c Start \c + \c 2*Stride, etc.
+     */
+    template<size_t Stride, size_t Start = 0>
+    CStridedSlice<T, detail::stridedSize(L, Start, Stride), Stride> cstrided() const {
+        STRIDED_METH_ASSERTS();
+        return CStridedSlice<T, detail::stridedSize(L, Start, Stride), Stride>(
+            this->_data + Start);
+    }
+
+    /**
+     * \brief Make a slice pointing to the same elements in reverse order.
+     */
+    CReversedSlice<T, L> creversed() const {
+        return CReversedSlice<T, L>(this->_data);
+    }
+
+    /**
+     * \brief Compare elements with those of another slice or array of the
+     * same size.
+     *
+     * \param other A \c CSlice, \c CStridedSlice, \c CReversedSlice or
+     * \c Array.  Its size is statically checked.
+     *
+     * \return Whether all the corresponding elements are equal.
+     */
+    template<typename Other>
+    bool operator==(const Other& other) const {
+        return detail::equalElems(*this, other);
+    }
+
+    /**
+     * \return The negation of \c operator==.
+     */
+    template<typename Other>
+    bool operator!=(const Other& other) const {
+        return !(*this == other);
+    }
+
     /**
      * \brief Get the number of instances of \c T in the slice.
      * 
@@ -269,6 +560,32 @@ public:
         return L * sizeof(T);
     }
 
+    /**
+     * \copydoc CArrayPtr::begin
+     */
+    const T *begin() const {
+        return this->_data;
+    }
+
+    /**
+     * \copydoc CArrayPtr::end
+     */
+    const T *end() const {
+        return this->_data + L;
+    }
+
+#ifdef SAFEARRAY_HAVE_SPAN
+    /**
+     * \brief Convert to a \c std::span of the same length without copying.
+     *
+     * Only available when compiling as C++20 with a standard library that
+     * has \c <span>.
+     */
+    operator std::span<const T, L>() const {
+        return std::span<const T, L>(this->_data, L);
+    }
+#endif
+
 protected:
     const T *_data;
 };
@@ -345,6 +662,10 @@ public:
         memcpy(this->data(), data.cdata(), data.sizeBytes());
     }
 
+    using CSlice<T, L>::operator==;
+    using CSlice<T, L>::operator!=;
+    using CSlice<T, L>::operator[];
+
     /**
      * \copydoc CSlice::operator[]
      */
@@ -352,6 +673,32 @@ public:
         return this->data()[i];
     }
 
+    using CSlice<T, L>::begin;
+    using CSlice<T, L>::end;
+
+    /**
+     * \copydoc CArrayPtr::begin
+     */
+    T *begin() {
+        return this->data();
+    }
+
+    /**
+     * \copydoc CArrayPtr::end
+     */
+    T *end() {
+        return this->data() + L;
+    }
+
+#ifdef SAFEARRAY_HAVE_SPAN
+    /**
+     * \copydoc CSlice::operator std::span<const T, L>
+     */
+    operator std::span<T, L>() {
+        return std::span<T, L>(this->data(), L);
+    }
+#endif
+
     /**
      * \copydoc CSlice::cslice
      */
@@ -360,6 +707,400 @@ public:
         SLICE_METH_ASSERTS();
         return Slice<T, End - Start>(this->data() + Start);
     }
+
+    /**
+     * \brief Copy data from a strided slice.
+     *
+     * \param data A slice from which to copy data.  Its size is statically
+     * checked to ensure memory-safety.  It must not overlap this slice.
+     */
+    template<size_t L2, size_t Stride>
+    void assign(CStridedSlice<T, L2, Stride> data) {
+        detail::assignElems(*this, data);
+    }
+
+    /**
+     * \brief Copy data from a reversed slice.
+     *
+     * \param data A slice from which to copy data.  Its size is statically
+     * checked to ensure memory-safety.  It must not overlap this slice.
+     */
+    template<size_t L2>
+    void assign(CReversedSlice<T, L2> data) {
+        detail::assignElems(*this, data);
+    }
+
+    /**
+     * \copydoc CSlice::cstrided
+     */
+    template<size_t Stride, size_t Start = 0>
+    StridedSlice<T, detail::stridedSize(L, Start, Stride), Stride> strided() {
+        STRIDED_METH_ASSERTS();
+        return StridedSlice<T, detail::stridedSize(L, Start, Stride), Stride>(
+            this->data() + Start);
+    }
+
+    /**
+     * \copydoc CSlice::creversed
+     */
+    ReversedSlice<T, L> reversed() {
+        return ReversedSlice<T, L>(this->data());
+    }
+
+    /**
+     * \brief Copy elements from one part of the slice to another, even if
+     * the parts overlap.
+     *
+     * The bounds given as template params are statically checked to ensure
+     * memory-safety.
+     *
+     * \tparam Src The index of the first element to copy.
+     * \tparam Dst The index to copy it to.
+     * \tparam N The number of elements to copy.
+     */
+    template<size_t Src, size_t Dst, size_t N>
+    void copyWithin() {
+        static_assert(Src + N <= L, "Bad source range");
+        static_assert(Dst + N <= L, "Bad destination range");
+        memmove(this->data() + Dst, this->cdata() + Src, N * sizeof(T));
+    }
+
+    /**
+     * \brief Move all elements \c N places toward the front, dropping the
+     * first \c N.
+     *
+     * This is how to consume parsed bytes from the front of a stream buffer.
+     * The last \c N elements keep their old values.
+     *
+     * \tparam N The number of places to move.  Statically checked to be
+     * \c <= \c L.
+     *
+     * \return A slice pointing to the last \c N elements, i.e., the space
+     * that was freed.
+     */
+    template<size_t N>
+    Slice<T, N> shiftLeft() {
+        static_assert(N <= L, "Bad shift");
+        memmove(this->data(), this->cdata() + N, (L - N) * sizeof(T));
+        return Slice<T, N>(this->data() + (L - N));
+    }
+
+    /**
+     * \brief Move all elements \c N places toward the back, dropping the
+     * last \c N.
+     *
+     * The first \c N elements keep their old values.
+     *
+     * \tparam N The number of places to move.  Statically checked to be
+     * \c <= \c L.
+     *
+     * \return A slice pointing to the first \c N elements, i.e., the space
+     * that was freed.
+     */
+    template<size_t N>
+    Slice<T, N> shiftRight() {
+        static_assert(N <= L, "Bad shift");
+        memmove(this->data() + N, this->cdata(), (L - N) * sizeof(T));
+        return Slice<T, N>(this->data());
+    }
+
+    /**
+     * \brief Rotate the elements \c N places toward the front, so that
+     * element \c N becomes element \c 0.
+     *
+     * Short rotations go through a small buffer on the stack with
+     * \c memmove; longer ones are done in place, so no scratch array is
+     * needed.
+     *
+     * \tparam N The number of places to rotate.  Statically checked to be
+     * \c <= \c L.
+     */
+    template<size_t N>
+    void rotate() {
+        static_assert(N <= L, "Bad rotation");
+        detail::Rotate<T, L, N>::run(this->data());
+    }
+};
+
+/**
+ * \brief A const pointer to elements of a C array that are evenly spaced.
+ *
+ * \tparam T The type of the elements of the slice.
+ * \tparam L The size (i.e., number of instances of \c T) of the slice.
+ * \tparam Stride The distance (in number of instances of \c T) between
+ * consecutive elements of the slice.
+ *
+ * Element \c i of the slice is element \c i \c * \c Stride of the
+ * underlying array, so the slice spans <tt>(L - 1) * Stride + 1</tt>
+ * elements.  A column of a row-major matrix is one example.
+ */
+template<typename T, size_t L, size_t Stride>
+class CStridedSlice
+{
+public:
+    static_assert(Stride > 0, "Bad stride");
+
+    /**
+     * \brief Make a slice whose first element is at the given location.
+     *
+     * WARNING: This class provides memory-safety only if the given pointer
+     * points to <tt>(L - 1) * Stride + 1</tt> contiguous instances of \c T.
+     */
+    explicit CStridedSlice(const T *data) : _data(data) {}
+
+    /**
+     * \brief Get a pointer to an element.
+     *
+     * \tparam Offset The index of the element.  The value is statically
+     * checked to ensure memory-safety.  Default: \c 0.
+     *
+     * \return A pointer to element \c Offset of the slice.
+     */
+    template<size_t Offset = 0>
+    const T *cdata() const {
+        DATA_METH_ASSERTS();
+        return this->_data + Offset * Stride;
+    }
+
+    /**
+     * \copydoc CSlice::operator[]
+     */
+    const T& operator[](size_t i) const {
+        return this->_data[i * Stride];
+    }
+
+    /**
+     * \copydoc CSlice::size
+     */
+    constexpr static size_t size() {
+        return L;
+    }
+
+    /**
+     * \brief Get the distance between consecutive elements.
+     *
+     * \return \c Stride
+     */
+    constexpr static size_t stride() {
+        return Stride;
+    }
+
+    /**
+     * \copydoc CSlice::operator==
+     */
+    template<typename Other>
+    bool operator==(const Other& other) const {
+        return detail::equalElems(*this, other);
+    }
+
+    /**
+     * \copydoc CSlice::operator!=
+     */
+    template<typename Other>
+    bool operator!=(const Other& other) const {
+        return !(*this == other);
+    }
+
+protected:
+    const T *_data;
+};
+
+/**
+ * \brief A pointer to elements of a C array that are evenly spaced.
+ *
+ * \tparam T The type of the elements of the slice.
+ * \tparam L The size (i.e., number of instances of \c T) of the slice.
+ * \tparam Stride The distance (in number of instances of \c T) between
+ * consecutive elements of the slice.
+ */
+template<typename T, size_t L, size_t Stride>
+class StridedSlice : public CStridedSlice<T, L, Stride>
+{
+public:
+    /**
+     * \copydoc CStridedSlice::CStridedSlice
+     */
+    explicit StridedSlice(T *data) : CStridedSlice<T, L, Stride>(data) {}
+
+    /**
+     * \copydoc CStridedSlice::cdata
+     */
+    template<size_t Offset = 0>
+    T *data() {
+        return (T *) this->template cdata<Offset>();
+    }
+
+    using CStridedSlice<T, L, Stride>::operator==;
+    using CStridedSlice<T, L, Stride>::operator!=;
+    using CStridedSlice<T, L, Stride>::operator[];
+
+    /**
+     * \copydoc Slice::operator[]
+     */
+    T& operator[](size_t i) {
+        return ((T *) this->_data)[i * Stride];
+    }
+
+    /**
+     * \copydoc Slice::fill
+     */
+    void fill(T val) {
+        for (size_t i = 0; i < L; ++i) {
+            (*this)[i] = val;
+        }
+    }
+
+    /**
+     * \brief Copy data from another slice or array, in one pass.
+     *
+     * \param data A \c CSlice, \c CStridedSlice, \c CReversedSlice or
+     * \c Array.  Its size is statically checked to ensure memory-safety.
+     * It must not overlap this slice.
+     */
+    template<typename Src>
+    void assign(const Src& data) {
+        detail::assignElems(*this, data);
+    }
+};
+
+/**
+ * \brief A const pointer to a section of a C array, whose elements are
+ * visited in reverse order.
+ *
+ * \tparam T The type of the elements of the slice.
+ * \tparam L The size (i.e., number of instances of \c T) of the slice.
+ *
+ * Element \c 0 of the slice is the last element of the section.
+ */
+template<typename T, size_t L>
+class CReversedSlice
+{
+public:
+    /**
+     * \brief Make a slice of the section that starts at the given location.
+     *
+     * WARNING: This class provides memory-safety only if the given pointer
+     * points to \c L contiguous instances of \c T.
+     *
+     * \param data A pointer to the lowest-addressed element of the section
+     * (which is the \em last element of the slice).
+     */
+    explicit CReversedSlice(const T *data) : _data(data) {}
+
+    /**
+     * \brief Get a pointer to an element.
+     *
+     * \tparam Offset The index of the element.  The value is statically
+     * checked to ensure memory-safety.  Default: \c 0.
+     *
+     * \return A pointer to element \c Offset of the slice.
+     */
+    template<size_t Offset = 0>
+    const T *cdata() const {
+        DATA_METH_ASSERTS();
+        return this->_data + (L - 1 - Offset);
+    }
+
+    /**
+     * \copydoc CSlice::operator[]
+     */
+    const T& operator[](size_t i) const {
+        return this->_data[L - 1 - i];
+    }
+
+    /**
+     * \brief Make a slice pointing to the same elements in their original
+     * order.
+     */
+    CSlice<T, L> creversed() const {
+        return CSlice<T, L>(this->_data);
+    }
+
+    /**
+     * \copydoc CSlice::size
+     */
+    constexpr static size_t size() {
+        return L;
+    }
+
+    /**
+     * \copydoc CSlice::operator==
+     */
+    template<typename Other>
+    bool operator==(const Other& other) const {
+        return detail::equalElems(*this, other);
+    }
+
+    /**
+     * \copydoc CSlice::operator!=
+     */
+    template<typename Other>
+    bool operator!=(const Other& other) const {
+        return !(*this == other);
+    }
+
+protected:
+    const T *_data;
+};
+
+/**
+ * \brief A pointer to a section of a C array, whose elements are visited
+ * in reverse order.
+ *
+ * \tparam T The type of the elements of the slice.
+ * \tparam L The size (i.e., number of instances of \c T) of the slice.
+ */
+template<typename T, size_t L>
+class ReversedSlice : public CReversedSlice<T, L>
+{
+public:
+    /**
+     * \copydoc CReversedSlice::CReversedSlice
+     */
+    explicit ReversedSlice(T *data) : CReversedSlice<T, L>(data) {}
+
+    /**
+     * \copydoc CReversedSlice::cdata
+     */
+    template<size_t Offset = 0>
+    T *data() {
+        return (T *) this->template cdata<Offset>();
+    }
+
+    using CReversedSlice<T, L>::operator==;
+    using CReversedSlice<T, L>::operator!=;
+    using CReversedSlice<T, L>::operator[];
+
+    /**
+     * \copydoc Slice::operator[]
+     */
+    T& operator[](size_t i) {
+        return ((T *) this->_data)[L - 1 - i];
+    }
+
+    /**
+     * \copydoc CReversedSlice::creversed
+     */
+    Slice<T, L> reversed() {
+        return Slice<T, L>((T *) this->_data);
+    }
+
+    /**
+     * \copydoc Slice::fill
+     */
+    void fill(T val) {
+        for (size_t i = 0; i < L; ++i) {
+            (*this)[i] = val;
+        }
+    }
+
+    /**
+     * \copydoc StridedSlice::assign
+     */
+    template<typename Src>
+    void assign(const Src& data) {
+        detail::assignElems(*this, data);
+    }
 };
 
 /**
@@ -377,6 +1118,7 @@ template<typename T, size_t L>
 class Array
 {
 public:
+#if __cplusplus < 202002L
     /**
      * \brief This constructor is deleted to prevent accidental copies.
      */
@@ -396,6 +1138,7 @@ public:
      * \brief This method is deleted to prevent accidental copies.
      */
     Array& operator=(Array& other) = delete;
+#endif
 
     /**
      * \copydoc CSlice::cdata
@@ -476,8 +1219,150 @@ public:
         return Slice<T, End - Start>(this->_data + Start);
     }
 
+    /**
+     * \copydoc Slice::assign(CStridedSlice<T, L2, Stride>)
+     */
+    template<size_t L2, size_t Stride>
+    void assign(CStridedSlice<T, L2, Stride> data) {
+        this->slice().assign(data);
+    }
+
+    /**
+     * \copydoc Slice::assign(CReversedSlice<T, L2>)
+     */
+    template<size_t L2>
+    void assign(CReversedSlice<T, L2> data) {
+        this->slice().assign(data);
+    }
+
+    /**
+     * \copydoc CSlice::cstrided
+     */
+    template<size_t Stride, size_t Start = 0>
+    CStridedSlice<T, detail::stridedSize(L, Start, Stride), Stride> cstrided() const {
+        return this->cslice().template cstrided<Stride, Start>();
+    }
+
+    /**
+     * \copydoc Slice::strided
+     */
+    template<size_t Stride, size_t Start = 0>
+    StridedSlice<T, detail::stridedSize(L, Start, Stride), Stride> strided() {
+        return this->slice().template strided<Stride, Start>();
+    }
+
+    /**
+     * \copydoc CSlice::creversed
+     */
+    CReversedSlice<T, L> creversed() const {
+        return this->cslice().creversed();
+    }
+
+    /**
+     * \copydoc Slice::reversed
+     */
+    ReversedSlice<T, L> reversed() {
+        return this->slice().reversed();
+    }
+
+    /**
+     * \copydoc Slice::copyWithin
+     */
+    template<size_t Src, size_t Dst, size_t N>
+    void copyWithin() {
+        this->slice().template copyWithin<Src, Dst, N>();
+    }
+
+    /**
+     * \copydoc Slice::shiftLeft
+     */
+    template<size_t N>
+    Slice<T, N> shiftLeft() {
+        return this->slice().template shiftLeft<N>();
+    }
+
+    /**
+     * \copydoc Slice::shiftRight
+     */
+    template<size_t N>
+    Slice<T, N> shiftRight() {
+        return this->slice().template shiftRight<N>();
+    }
+
+    /**
+     * \copydoc Slice::rotate
+     */
+    template<size_t N>
+    void rotate() {
+        this->slice().template rotate<N>();
+    }
+
+    /**
+     * \copydoc CSlice::operator==
+     */
+    template<typename Other>
+    bool operator==(const Other& other) const {
+        return detail::equalElems(*this, other);
+    }
+
+    /**
+     * \copydoc CSlice::operator!=
+     */
+    template<typename Other>
+    bool operator!=(const Other& other) const {
+        return !(*this == other);
+    }
+
+    /**
+     * \copydoc CArrayPtr::begin
+     */
+    const T *begin() const {
+        return this->_data;
+    }
+
+    /**
+     * \copydoc CArrayPtr::end
+     */
+    const T *end() const {
+        return this->_data + L;
+    }
+
+    /**
+     * \copydoc CArrayPtr::begin
+     */
+    T *begin() {
+        return this->_data;
+    }
+
+    /**
+     * \copydoc CArrayPtr::end
+     */
+    T *end() {
+        return this->_data + L;
+    }
+
+#ifdef SAFEARRAY_HAVE_SPAN
+    /**
+     * \copydoc CSlice::operator std::span<const T, L>
+     */
+    operator std::span<const T, L>() const {
+        return std::span<const T, L>(this->_data, L);
+    }
+
+    /**
+     * \copydoc CSlice::operator std::span<const T, L>
+     */
+    operator std::span<T, L>() {
+        return std::span<T, L>(this->_data, L);
+    }
+#endif
+
     T _data[L];
-} __attribute__((packed));
+
+#if __cplusplus >= 202002L
+    [[no_unique_address]] detail::NonCopyable _noCopy = {};
+#endif
+};
 
 static_assert(sizeof(Array<char, 10>) == 10, "Bad definition of Array");
 
@@ -0,0 +1,413 @@
+#ifndef __MCU_SAFE_ARRAY2D_H__
+#define __MCU_SAFE_ARRAY2D_H__
+
+/**
+ * \file
+ *
+ * Two-dimensional arrays with compile-time checked row, column and block
+ * views.
+ */
+
+#include "mcu_safe_array.h"
+
+#define ROW_METH_ASSERTS() \
+    do { \
+        static_assert(I < H, "Bad row index"); \
+    } while (false);
+
+#define COL_METH_ASSERTS() \
+    do { \
+        static_assert(J < W, "Bad column index"); \
+    } while (false);
+
+#define ELEM_METH_ASSERTS() \
+    do { \
+        static_assert(I < H, "Bad row index"); \
+        static_assert(J < W, "Bad column index"); \
+    } while (false);
+
+#define BLOCK_METH_ASSERTS() \
+    do { \
+        static_assert(R0 + H2 <= H, "Bad block rows"); \
+        static_assert(C0 + W2 <= W, "Bad block columns"); \
+    } while (false);
+
+namespace safearray {
+
+/**
+ * \brief A const pointer to a rectangular section of a row-major matrix.
+ *
+ * \tparam T The type of the elements.
+ * \tparam H The number of rows in the section.
+ * \tparam W The number of columns in the section.
+ * \tparam Stride The distance (in number of instances of \c T) between the
+ * starts of consecutive rows, i.e., the number of columns of the
+ * underlying matrix.
+ *
+ * Methods that take indices as template params are statically
+ * bounds-checked.
+ */
+template<typename T, size_t H, size_t W, size_t Stride>
+class CSlice2D
+{
+public:
+    static_assert(W <= Stride, "Bad stride");
+
+    /**
+     * \brief Make a slice whose top-left element is at the given location.
+     *
+     * WARNING: This class provides memory-safety only if the given pointer
+     * points to <tt>(H - 1) * Stride + W</tt> contiguous instances of \c T.
+     */
+    explicit CSlice2D(const T *data) : _data(data) {}
+
+    /**
+     * \brief Get an element whose indices are known at compile-time.
+     *
+     * \tparam I The row index.
+     * \tparam J The column index.
+     */
+    template<size_t I, size_t J>
+    const T& cat() const {
+        ELEM_METH_ASSERTS();
+        return this->_data[I * Stride + J];
+    }
+
+    /**
+     * \brief Get the element at a particular row and column.
+     *
+     * WARNING: This method does no static or runtime bounds-checking.
+     */
+    const T& operator()(size_t i, size_t j) const {
+        return this->_data[i * Stride + j];
+    }
+
+    /**
+     * \brief Make a slice pointing to a row.
+     *
+     * \tparam I The row index.  The value is statically checked to ensure
+     * memory-safety.
+     */
+    template<size_t I>
+    CSlice<T, W> crow() const {
+        ROW_METH_ASSERTS();
+        return CSlice<T, W>(this->_data + I * Stride);
+    }
+
+    /**
+     * \brief Make a slice pointing to a column.
+     *
+     * \tparam J The column index.  The value is statically checked to ensure
+     * memory-safety.
+     */
+    template<size_t J>
+    CStridedSlice<T, H, Stride> ccol() const {
+        COL_METH_ASSERTS();
+        return CStridedSlice<T, H, Stride>(this->_data + J);
+    }
+
+    /**
+     * \brief Make a slice pointing to a rectangular section.
+     *
+     * The bounds given as template params are statically checked to ensure
+     * memory-safety.
+     *
+     * \tparam R0 The index of the section's first row.
+     * \tparam C0 The index of the section's first column.
+     * \tparam H2 The number of rows in the section.
+     * \tparam W2 The number of columns in the section.
+     */
+    template<size_t R0, size_t C0, size_t H2, size_t W2>
+    CSlice2D<T, H2, W2, Stride> cblock() const {
+        BLOCK_METH_ASSERTS();
+        return CSlice2D<T, H2, W2, Stride>(this->_data + R0 * Stride + C0);
+    }
+
+    /**
+     * \brief Get the number of rows.
+     */
+    constexpr static size_t rows() {
+        return H;
+    }
+
+    /**
+     * \brief Get the number of columns.
+     */
+    constexpr static size_t cols() {
+        return W;
+    }
+
+protected:
+    const T *_data;
+};
+
+/**
+ * \brief A pointer to a rectangular section of a row-major matrix.
+ *
+ * \tparam T The type of the elements.
+ * \tparam H The number of rows in the section.
+ * \tparam W The number of columns in the section.
+ * \tparam Stride The distance (in number of instances of \c T) between the
+ * starts of consecutive rows.
+ */
+template<typename T, size_t H, size_t W, size_t Stride>
+class Slice2D : public CSlice2D<T, H, W, Stride>
+{
+public:
+    /**
+     * \copydoc CSlice2D::CSlice2D
+     */
+    explicit Slice2D(T *data) : CSlice2D<T, H, W, Stride>(data) {}
+
+    /**
+     * \copydoc CSlice2D::cat
+     */
+    template<size_t I, size_t J>
+    T& at() {
+        return (T&) this->template cat<I, J>();
+    }
+
+    /**
+     * \copydoc CSlice2D::operator()
+     */
+    T& operator()(size_t i, size_t j) {
+        return this->data()[i * Stride + j];
+    }
+
+    /**
+     * \copydoc CSlice2D::crow
+     */
+    template<size_t I>
+    Slice<T, W> row() {
+        ROW_METH_ASSERTS();
+        return Slice<T, W>(this->data() + I * Stride);
+    }
+
+    /**
+     * \copydoc CSlice2D::ccol
+     */
+    template<size_t J>
+    StridedSlice<T, H, Stride> col() {
+        COL_METH_ASSERTS();
+        return StridedSlice<T, H, Stride>(this->data() + J);
+    }
+
+    /**
+     * \copydoc CSlice2D::cblock
+     */
+    template<size_t R0, size_t C0, size_t H2, size_t W2>
+    Slice2D<T, H2, W2, Stride> block() {
+        BLOCK_METH_ASSERTS();
+        return Slice2D<T, H2, W2, Stride>(this->data() + R0 * Stride + C0);
+    }
+
+    /**
+     * \brief Fill with the given value.
+     */
+    void fill(T val) {
+        for (size_t i = 0; i < H; ++i) {
+            for (size_t j = 0; j < W; ++j) {
+                (*this)(i, j) = val;
+            }
+        }
+    }
+
+private:
+    T *data() {
+        return (T *) this->_data;
+    }
+};
+
+/**
+ * \brief A two-dimensional array with dimensions known at compile-time.
+ *
+ * \tparam T The type of the elements of the array.
+ * \tparam R The number of rows.
+ * \tparam C The number of columns.
+ *
+ * Elements are stored in row-major order, and instances take up the same
+ * amount of space as a C array <tt>T[R][C]</tt>.  Rows are contiguous, so
+ * they're plain \c Slices; columns are \c StridedSlices.
+ */
+template<typename T, size_t R, size_t C>
+class Array2D
+{
+public:
+#if __cplusplus < 202002L
+    /**
+     * \brief This constructor is deleted to prevent accidental copies.
+     */
+    Array2D(const Array2D& other) = delete;
+
+    /**
+     * \brief This constructor is deleted to prevent accidental copies.
+     */
+    Array2D(Array2D& other) = delete;
+
+    /**
+     * \brief This method is deleted to prevent accidental copies.
+     */
+    Array2D& operator=(const Array2D& other) = delete;
+
+    /**
+     * \brief This method is deleted to prevent accidental copies.
+     */
+    Array2D& operator=(Array2D& other) = delete;
+#endif
+
+    /**
+     * \copydoc CSlice2D::cat
+     */
+    template<size_t I, size_t J>
+    const T& cat() const {
+        return this->cblock().template cat<I, J>();
+    }
+
+    /**
+     * \copydoc Slice2D::at
+     */
+    template<size_t I, size_t J>
+    T& at() {
+        return this->block().template at<I, J>();
+    }
+
+    /**
+     * \copydoc CSlice2D::operator()
+     */
+    const T& operator()(size_t i, size_t j) const {
+        return this->_data[i * C + j];
+    }
+
+    /**
+     * \copydoc Slice2D::operator()
+     */
+    T& operator()(size_t i, size_t j) {
+        return this->_data[i * C + j];
+    }
+
+    /**
+     * \copydoc CSlice2D::crow
+     */
+    template<size_t I>
+    CSlice<T, C> crow() const {
+        return this->cblock().template crow<I>();
+    }
+
+    /**
+     * \copydoc Slice2D::row
+     */
+    template<size_t I>
+    Slice<T, C> row() {
+        return this->block().template row<I>();
+    }
+
+    /**
+     * \copydoc CSlice2D::ccol
+     */
+    template<size_t J>
+    CStridedSlice<T, R, C> ccol() const {
+        return this->cblock().template ccol<J>();
+    }
+
+    /**
+     * \copydoc Slice2D::col
+     */
+    template<size_t J>
+    StridedSlice<T, R, C> col() {
+        return this->block().template col<J>();
+    }
+
+    /**
+     * \copydoc CSlice2D::cblock
+     */
+    template<size_t R0 = 0, size_t C0 = 0, size_t H2 = R - R0, size_t W2 = C - C0>
+    CSlice2D<T, H2, W2, C> cblock() const {
+        static_assert(R0 + H2 <= R, "Bad block rows");
+        static_assert(C0 + W2 <= C, "Bad block columns");
+        return CSlice2D<T, H2, W2, C>(this->_data + R0 * C + C0);
+    }
+
+    /**
+     * \copydoc Slice2D::block
+     */
+    template<size_t R0 = 0, size_t C0 = 0, size_t H2 = R - R0, size_t W2 = C - C0>
+    Slice2D<T, H2, W2, C> block() {
+        static_assert(R0 + H2 <= R, "Bad block rows");
+        static_assert(C0 + W2 <= C, "Bad block columns");
+        return Slice2D<T, H2, W2, C>(this->_data + R0 * C + C0);
+    }
+
+    /**
+     * \brief Make a slice pointing to all the elements, in row-major order.
+     */
+    CSlice<T, R * C> cflat() const {
+        return CSlice<T, R * C>(this->_data);
+    }
+
+    /**
+     * \copydoc Array2D::cflat
+     */
+    Slice<T, R * C> flat() {
+        return Slice<T, R * C>(this->_data);
+    }
+
+    /**
+     * \copydoc Slice::fill
+     */
+    void fill(T val) {
+        this->flat().fill(val);
+    }
+
+    /**
+     * \copydoc CSlice2D::rows
+     */
+    constexpr static size_t rows() {
+        return R;
+    }
+
+    /**
+     * \copydoc CSlice2D::cols
+     */
+    constexpr static size_t cols() {
+        return C;
+    }
+
+    T _data[R * C];
+
+#if __cplusplus >= 202002L
+    [[no_unique_address]] detail::NonCopyable _noCopy = {};
+#endif
+};
+
+static_assert(sizeof(Array2D<char, 3, 5>) == 15, "Bad definition of Array2D");
+
+/**
+ * \brief Transpose a matrix into another.
+ *
+ * The matrix is processed in \c Tile x \c Tile blocks, so that the reads
+ * and the writes of each block stay within a few cache lines.
+ *
+ * \tparam Tile The size of the blocks.  Default: \c 8.
+ *
+ * \param src The matrix to transpose.
+ * \param dest Set to the transpose of \c src.  Must not overlap \c src.
+ */
+template<size_t Tile = 8, typename T, size_t R, size_t C>
+void transpose(const Array2D<T, R, C>& src, Array2D<T, C, R>& dest) {
+    static_assert(Tile > 0, "Bad tile size");
+    for (size_t i0 = 0; i0 < R; i0 += Tile) {
+        size_t i1 = i0 + Tile < R ? i0 + Tile : R;
+        for (size_t j0 = 0; j0 < C; j0 += Tile) {
+            size_t j1 = j0 + Tile < C ? j0 + Tile : C;
+            for (size_t i = i0; i < i1; ++i) {
+                for (size_t j = j0; j < j1; ++j) {
+                    dest(j, i) = src(i, j);
+                }
+            }
+        }
+    }
+}
+
+} // namespace safearray
+
+#endif
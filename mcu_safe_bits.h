@@ -0,0 +1,898 @@
+#ifndef __MCU_SAFE_BITS_H__
+#define __MCU_SAFE_BITS_H__
+
+/**
+ * \file
+ *
+ * Arrays of bits packed into words, and slices of them, along with readers
+ * and writers for fields of arbitrary bit widths packed into bytes.
+ */
+
+#include "mcu_safe_array.h"
+
+#define BIT_INDEX_ASSERTS() \
+    do { \
+        static_assert(I < L, "Bad bit index"); \
+    } while (false);
+
+namespace safearray {
+
+namespace detail {
+
+/**
+ * The word in which bits are stored.  It's the widest type that the
+ * target can operate on in one instruction.
+ */
+#ifdef __AVR__
+typedef uint8_t BitWord;
+#else
+typedef unsigned long BitWord;
+#endif
+
+constexpr size_t BIT_WORD_BITS = sizeof(BitWord) * 8;
+
+constexpr size_t bitWords(size_t bits) {
+    return (bits + BIT_WORD_BITS - 1) / BIT_WORD_BITS;
+}
+
+inline BitWord lowBits(size_t n) {
+    return n >= BIT_WORD_BITS ? (BitWord) ~(BitWord) 0
+        : (BitWord) (((BitWord) 1 << n) - 1);
+}
+
+inline unsigned popcount(BitWord w) {
+#ifdef __AVR__
+    return __builtin_popcount(w);
+#else
+    return __builtin_popcountl(w);
+#endif
+}
+
+inline unsigned countTrailingZeros(BitWord w) {
+#ifdef __AVR__
+    return __builtin_ctz(w);
+#else
+    return __builtin_ctzl(w);
+#endif
+}
+
+/**
+ * Walk the range of \c len bits starting at bit \c start a word at a time,
+ * calling <tt>f(wordIndex, mask, base)</tt> for each word the range
+ * touches.  \c mask selects the bits of that word that are in the range,
+ * and bit \c b of that word has index <tt>base + b</tt> in the range (using
+ * unsigned wraparound for the first word).  Stops early if \c f returns
+ * \c false.
+ */
+template<typename F>
+void forEachBitWord(size_t start, size_t len, F f) {
+    size_t i = start / BIT_WORD_BITS;
+    size_t bit = start % BIT_WORD_BITS;
+    size_t done = 0;
+    while (done < len) {
+        size_t n = BIT_WORD_BITS - bit;
+        if (n > len - done) {
+            n = len - done;
+        }
+        if (!f(i, (BitWord) (lowBits(n) << bit), done - bit)) {
+            return;
+        }
+        done += n;
+        bit = 0;
+        ++i;
+    }
+}
+
+} // namespace detail
+
+/**
+ * \brief A const pointer to a section of an array of packed bits.
+ *
+ * \tparam L The number of bits in the slice.
+ *
+ * Like \c CSlice, the length is known at compile-time, so methods that take
+ * indices as template params are statically bounds-checked.  The slice
+ * needn't start on a word boundary.
+ */
+template<size_t L>
+class CBitSlice
+{
+public:
+    /**
+     * \brief Make a slice pointing to \c L bits at the given location.
+     *
+     * WARNING: This class provides memory-safety only if the given pointer
+     * points to words holding at least \c start \c + \c L bits.
+     *
+     * \param words A pointer to the words holding the bits.
+     * \param start The index of the slice's first bit in \c words.
+     */
+    CBitSlice(const detail::BitWord *words, size_t start)
+        : _words(words + start / detail::BIT_WORD_BITS),
+          _start(start % detail::BIT_WORD_BITS) {}
+
+    /**
+     * \brief Get the bit at a particular index.
+     *
+     * \tparam I An index.  The value is statically checked to ensure
+     * memory-safety.
+     */
+    template<size_t I>
+    bool test() const {
+        BIT_INDEX_ASSERTS();
+        return this->test(I);
+    }
+
+    /**
+     * \brief Get the bit at a particular index.
+     *
+     * WARNING: This method does no static or runtime bounds-checking.
+     *
+     * \param i An index.  If \c i \c >= \c L, the return value is undefined.
+     */
+    bool test(size_t i) const {
+        size_t pos = this->_start + i;
+        return (this->_words[pos / detail::BIT_WORD_BITS]
+            >> (pos % detail::BIT_WORD_BITS)) & 1;
+    }
+
+    /**
+     * \brief Count the bits that are set.
+     *
+     * \return The number of bits that are set.
+     */
+    size_t popcount() const {
+        size_t count = 0;
+        const detail::BitWord *words = this->_words;
+        detail::forEachBitWord(this->_start, L,
+            [&](size_t i, detail::BitWord mask, size_t) {
+                count += detail::popcount(words[i] & mask);
+                return true;
+            });
+        return count;
+    }
+
+    /**
+     * \brief Find the first bit that is set.
+     *
+     * \return The index of the first bit that is set, or \c L if none are.
+     */
+    size_t findFirstSet() const {
+        size_t found = L;
+        const detail::BitWord *words = this->_words;
+        detail::forEachBitWord(this->_start, L,
+            [&](size_t i, detail::BitWord mask, size_t base) {
+                detail::BitWord w = words[i] & mask;
+                if (w == 0) {
+                    return true;
+                }
+                found = base + detail::countTrailingZeros(w);
+                return false;
+            });
+        return found;
+    }
+
+    /**
+     * \return Whether any bit is set.
+     */
+    bool any() const {
+        return this->findFirstSet() != L;
+    }
+
+    /**
+     * \brief Make a slice pointing to a section of the bits.
+     *
+     * The bounds given as template params are statically checked to ensure
+     * memory-safety.
+     *
+     * \tparam Start The index of the first bit in the slice.  Default: \c 0.
+     * \tparam End The next index after the index of the last bit in the
+     * slice.  Default: \c L.
+     */
+    template<size_t Start = 0, size_t End = L>
+    CBitSlice<End - Start> cslice() const {
+        SLICE_METH_ASSERTS();
+        return CBitSlice<End - Start>(this->_words, this->_start + Start);
+    }
+
+    /**
+     * \brief Get the number of bits in the slice.
+     */
+    constexpr static size_t size() {
+        return L;
+    }
+
+protected:
+    const detail::BitWord *_words;
+    size_t _start;
+};
+
+/**
+ * \brief A pointer to a section of an array of packed bits.
+ *
+ * \tparam L The number of bits in the slice.
+ */
+template<size_t L>
+class BitSlice : public CBitSlice<L>
+{
+public:
+    /**
+     * \copydoc CBitSlice::CBitSlice
+     */
+    BitSlice(detail::BitWord *words, size_t start)
+        : CBitSlice<L>(words, start) {}
+
+    /**
+     * \brief Set the bit at a particular index.
+     *
+     * \tparam I An index.  The value is statically checked to ensure
+     * memory-safety.
+     * \param val The value to give the bit.  Default: \c true.
+     */
+    template<size_t I>
+    void set(bool val = true) {
+        BIT_INDEX_ASSERTS();
+        this->set(I, val);
+    }
+
+    /**
+     * \brief Set the bit at a particular index.
+     *
+     * WARNING: This method does no static or runtime bounds-checking.
+     *
+     * \param i An index.  If \c i \c >= \c L, the behavior is undefined.
+     * \param val The value to give the bit.  Default: \c true.
+     */
+    void set(size_t i, bool val = true) {
+        size_t pos = this->_start + i;
+        detail::BitWord bit = (detail::BitWord) 1 << (pos % detail::BIT_WORD_BITS);
+        detail::BitWord& w = this->words()[pos / detail::BIT_WORD_BITS];
+        w = val ? (detail::BitWord) (w | bit) : (detail::BitWord) (w & ~bit);
+    }
+
+    /**
+     * \brief Clear the bit at a particular index.
+     *
+     * \tparam I An index.  The value is statically checked to ensure
+     * memory-safety.
+     */
+    template<size_t I>
+    void reset() {
+        this->template set<I>(false);
+    }
+
+    /**
+     * \brief Clear the bit at a particular index.
+     *
+     * WARNING: This method does no static or runtime bounds-checking.
+     */
+    void reset(size_t i) {
+        this->set(i, false);
+    }
+
+    /**
+     * \brief Give every bit the same value, a word at a time.
+     */
+    void fill(bool val) {
+        detail::BitWord *words = this->words();
+        detail::forEachBitWord(this->_start, L,
+            [&](size_t i, detail::BitWord mask, size_t) {
+                words[i] = val ? (detail::BitWord) (words[i] | mask)
+                    : (detail::BitWord) (words[i] & ~mask);
+                return true;
+            });
+    }
+
+    /**
+     * \copydoc CBitSlice::cslice
+     */
+    template<size_t Start = 0, size_t End = L>
+    BitSlice<End - Start> slice() {
+        SLICE_METH_ASSERTS();
+        return BitSlice<End - Start>(this->words(), this->_start + Start);
+    }
+
+private:
+    detail::BitWord *words() {
+        return (detail::BitWord *) this->_words;
+    }
+};
+
+/**
+ * \brief An array of bits with a fixed length known at compile-time.
+ *
+ * \tparam N The number of bits.
+ *
+ * The bits are packed into native words, so this takes an eighth of the
+ * space of an \c Array<bool, N>.  Operations over whole arrays are done a
+ * word at a time, using compiler builtins for counting bits.
+ */
+template<size_t N>
+class BitArray
+{
+public:
+    /**
+     * \brief Make an array with all bits cleared.
+     */
+    BitArray() {
+        this->fill(false);
+    }
+
+    /**
+     * \brief This constructor is deleted to prevent accidental copies.
+     */
+    BitArray(const BitArray& other) = delete;
+
+    /**
+     * \brief This method is deleted to prevent accidental copies.
+     */
+    BitArray& operator=(const BitArray& other) = delete;
+
+    /**
+     * \copydoc CBitSlice::test() const
+     */
+    template<size_t I>
+    bool test() const {
+        static_assert(I < N, "Bad bit index");
+        return this->cslice().test(I);
+    }
+
+    /**
+     * \copydoc CBitSlice::test(size_t) const
+     */
+    bool test(size_t i) const {
+        return this->cslice().test(i);
+    }
+
+    /**
+     * \copydoc BitSlice::set(bool)
+     */
+    template<size_t I>
+    void set(bool val = true) {
+        this->slice().template set<I>(val);
+    }
+
+    /**
+     * \copydoc BitSlice::set(size_t, bool)
+     */
+    void set(size_t i, bool val = true) {
+        this->slice().set(i, val);
+    }
+
+    /**
+     * \copydoc BitSlice::reset()
+     */
+    template<size_t I>
+    void reset() {
+        this->slice().template reset<I>();
+    }
+
+    /**
+     * \copydoc BitSlice::reset(size_t)
+     */
+    void reset(size_t i) {
+        this->slice().reset(i);
+    }
+
+    /**
+     * \copydoc BitSlice::fill
+     */
+    void fill(bool val) {
+        for (size_t i = 0; i < WORDS; ++i) {
+            this->_words[i] = val ? (detail::BitWord) ~(detail::BitWord) 0 : 0;
+        }
+        this->clearTail();
+    }
+
+    /**
+     * \copydoc CBitSlice::popcount
+     */
+    size_t popcount() const {
+        size_t count = 0;
+        for (size_t i = 0; i < WORDS; ++i) {
+            count += detail::popcount(this->_words[i]);
+        }
+        return count;
+    }
+
+    /**
+     * \copydoc CBitSlice::findFirstSet
+     */
+    size_t findFirstSet() const {
+        for (size_t i = 0; i < WORDS; ++i) {
+            if (this->_words[i] != 0) {
+                return i * detail::BIT_WORD_BITS
+                    + detail::countTrailingZeros(this->_words[i]);
+            }
+        }
+        return N;
+    }
+
+    /**
+     * \copydoc CBitSlice::any
+     */
+    bool any() const {
+        for (size_t i = 0; i < WORDS; ++i) {
+            if (this->_words[i] != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * \brief Invert every bit.
+     */
+    void flip() {
+        for (size_t i = 0; i < WORDS; ++i) {
+            this->_words[i] = (detail::BitWord) ~this->_words[i];
+        }
+        this->clearTail();
+    }
+
+    /**
+     * \brief Bitwise-AND another array into this one.
+     */
+    BitArray& operator&=(const BitArray& other) {
+        for (size_t i = 0; i < WORDS; ++i) {
+            this->_words[i] &= other._words[i];
+        }
+        return *this;
+    }
+
+    /**
+     * \brief Bitwise-OR another array into this one.
+     */
+    BitArray& operator|=(const BitArray& other) {
+        for (size_t i = 0; i < WORDS; ++i) {
+            this->_words[i] |= other._words[i];
+        }
+        return *this;
+    }
+
+    /**
+     * \brief Bitwise-XOR another array into this one.
+     */
+    BitArray& operator^=(const BitArray& other) {
+        for (size_t i = 0; i < WORDS; ++i) {
+            this->_words[i] ^= other._words[i];
+        }
+        return *this;
+    }
+
+    /**
+     * \return Whether both arrays have the same bits set.
+     */
+    bool operator==(const BitArray& other) const {
+        return memcmp(this->_words, other._words, sizeof(this->_words)) == 0;
+    }
+
+    /**
+     * \copydoc CBitSlice::cslice
+     */
+    template<size_t Start = 0, size_t End = N>
+    CBitSlice<End - Start> cslice() const {
+        static_assert(Start <= N, "Bad start index");
+        static_assert(End <= N, "Bad end index");
+        static_assert(End >= Start, "Bad end index");
+        return CBitSlice<End - Start>(this->_words, Start);
+    }
+
+    /**
+     * \copydoc BitSlice::slice
+     */
+    template<size_t Start = 0, size_t End = N>
+    BitSlice<End - Start> slice() {
+        static_assert(Start <= N, "Bad start index");
+        static_assert(End <= N, "Bad end index");
+        static_assert(End >= Start, "Bad end index");
+        return BitSlice<End - Start>(this->_words, Start);
+    }
+
+    /**
+     * \copydoc CBitSlice::size
+     */
+    constexpr static size_t size() {
+        return N;
+    }
+
+private:
+    static constexpr size_t WORDS = detail::bitWords(N);
+
+    /**
+     * Keep the unused bits of the last word cleared, so that whole-word
+     * operations like \c popcount don't need to mask them.
+     */
+    void clearTail() {
+        if (N % detail::BIT_WORD_BITS != 0) {
+            this->_words[WORDS - 1] &= detail::lowBits(N % detail::BIT_WORD_BITS);
+        }
+    }
+
+    detail::BitWord _words[WORDS];
+};
+
+/**
+ * \brief The order in which bits are packed into bytes.
+ */
+enum class BitOrder {
+    /**
+     * The first bit is the most-significant bit of the first byte, and
+     * fields are stored most-significant bit first.
+     */
+    MSB_FIRST,
+
+    /**
+     * The first bit is the least-significant bit of the first byte, and
+     * fields are stored least-significant bit first.
+     */
+    LSB_FIRST,
+};
+
+namespace detail {
+
+/**
+ * The bit cache used by \c BitReader and \c BitWriter.
+ */
+#if UINTPTR_MAX > 0xffffffff
+typedef uint64_t BitCache;
+#else
+typedef uint32_t BitCache;
+#endif
+
+constexpr size_t BIT_CACHE_BITS = sizeof(BitCache) * 8;
+
+/**
+ * The widest field that can be taken from the cache after refilling it a
+ * byte at a time.
+ */
+constexpr size_t BIT_CACHE_CHUNK = BIT_CACHE_BITS - 7;
+
+/**
+ * An integer wide enough to hold the bytes spanned by a field.
+ */
+template<bool Wide> struct FieldAccum { typedef uint32_t type; };
+template<> struct FieldAccum<true> { typedef uint64_t type; };
+
+template<size_t Pos, size_t Width>
+struct FieldSpan {
+    static constexpr size_t FIRST = Pos / 8;
+    static constexpr size_t LAST = (Pos + Width - 1) / 8;
+    static constexpr size_t BYTES = LAST - FIRST + 1;
+    static constexpr size_t MSB_SHIFT = (LAST + 1) * 8 - (Pos + Width);
+    static constexpr size_t LSB_SHIFT = Pos % 8;
+    typedef typename FieldAccum<(BYTES > 4)>::type Accum;
+};
+
+inline uint32_t fieldMask(size_t width) {
+    return width >= 32 ? 0xffffffffUL : (uint32_t) ((1UL << width) - 1);
+}
+
+} // namespace detail
+
+#define BIT_FIELD_ASSERTS() \
+    do { \
+        static_assert(Width > 0 && Width <= 32, "Bad field width"); \
+        static_assert(Pos + Width <= L * 8, "Bad field position"); \
+    } while (false);
+
+/**
+ * \brief Read a field at a position known at compile-time.
+ *
+ * \tparam Pos The index of the field's first bit.
+ * \tparam Width The number of bits in the field (at most 32).
+ * \tparam Order How bits are packed into bytes.  Default: \c MSB_FIRST.
+ *
+ * The field's position is statically checked to ensure memory-safety.
+ *
+ * \param data The bytes holding the field.
+ *
+ * \return The field's value.
+ */
+template<size_t Pos, size_t Width, BitOrder Order = BitOrder::MSB_FIRST, size_t L>
+uint32_t getBits(CByteSlice<L> data) {
+    BIT_FIELD_ASSERTS();
+    typedef detail::FieldSpan<Pos, Width> Span;
+    typename Span::Accum acc = 0;
+    for (size_t i = 0; i < Span::BYTES; ++i) {
+        typename Span::Accum b = data[Span::FIRST + i];
+        if (Order == BitOrder::MSB_FIRST) {
+            acc = (acc << 8) | b;
+        } else {
+            acc |= b << (8 * i);
+        }
+    }
+    size_t shift = Order == BitOrder::MSB_FIRST ? Span::MSB_SHIFT : Span::LSB_SHIFT;
+    return (uint32_t) (acc >> shift) & detail::fieldMask(Width);
+}
+
+/**
+ * \brief Write a field at a position known at compile-time, leaving the
+ * surrounding bits unchanged.
+ *
+ * \tparam Pos The index of the field's first bit.
+ * \tparam Width The number of bits in the field (at most 32).
+ * \tparam Order How bits are packed into bytes.  Default: \c MSB_FIRST.
+ *
+ * The field's position is statically checked to ensure memory-safety.
+ *
+ * \param data The bytes to hold the field.
+ * \param value The field's value.  Bits above \c Width are ignored.
+ */
+template<size_t Pos, size_t Width, BitOrder Order = BitOrder::MSB_FIRST, size_t L>
+void setBits(ByteSlice<L> data, uint32_t value) {
+    BIT_FIELD_ASSERTS();
+    typedef detail::FieldSpan<Pos, Width> Span;
+    size_t shift = Order == BitOrder::MSB_FIRST ? Span::MSB_SHIFT : Span::LSB_SHIFT;
+    typename Span::Accum mask = (typename Span::Accum) detail::fieldMask(Width) << shift;
+    typename Span::Accum v = ((typename Span::Accum) value << shift) & mask;
+    for (size_t i = 0; i < Span::BYTES; ++i) {
+        size_t byteShift = Order == BitOrder::MSB_FIRST
+            ? 8 * (Span::BYTES - 1 - i) : 8 * i;
+        unsigned char m = (unsigned char) (mask >> byteShift);
+        unsigned char& b = data[Span::FIRST + i];
+        b = (unsigned char) ((b & ~m) | ((v >> byteShift) & m));
+    }
+}
+
+/**
+ * \brief Reads fields of arbitrary bit widths one after another from a
+ * byte slice.
+ *
+ * \tparam L The number of bytes in the slice.
+ * \tparam Order How bits are packed into bytes.  Default: \c MSB_FIRST.
+ *
+ * Bytes are loaded into a word-sized cache, so each byte is read from
+ * memory once no matter how many fields it's split across.
+ *
+ * \code
+ * safearray::BitReader<sizeof(frame)> r(frame.cslice());
+ * uint32_t type, seq, len;
+ * if (!r.read(3, type) || !r.read(5, seq) || !r.read(11, len)) {
+ *     return; // frame too short
+ * }
+ * \endcode
+ */
+template<size_t L, BitOrder Order = BitOrder::MSB_FIRST>
+class BitReader
+{
+public:
+    /**
+     * \brief Make a reader that starts at the beginning of a slice.
+     */
+    explicit BitReader(CByteSlice<L> data)
+        : _data(data), _pos(0), _cache(0), _cacheBits(0) {}
+
+    /**
+     * \brief Read the next field.
+     *
+     * \param width The number of bits in the field (at most 32).
+     * \param out Set to the field's value.
+     *
+     * \return \c false (and nothing is consumed) iff there aren't \c width
+     * bits left or \c width is too large.
+     */
+    bool read(size_t width, uint32_t& out) {
+        if (width > 32 || width > this->remaining()) {
+            return false;
+        }
+        if (width > detail::BIT_CACHE_CHUNK) {
+            // too wide for one refill, so take it in two parts
+            size_t rest = width - 16;
+            if (Order == BitOrder::MSB_FIRST) {
+                uint32_t a = this->take(rest);
+                out = (a << 16) | this->take(16);
+            } else {
+                uint32_t a = this->take(16);
+                out = a | (this->take(rest) << 16);
+            }
+        } else {
+            out = this->take(width);
+        }
+        return true;
+    }
+
+    /**
+     * \brief Skip bits.
+     *
+     * \return \c false (and nothing is skipped) iff there aren't \c bits
+     * bits left.
+     */
+    bool skip(size_t bits) {
+        if (bits > this->remaining()) {
+            return false;
+        }
+        while (bits > 0) {
+            size_t n = bits > detail::BIT_CACHE_CHUNK ? detail::BIT_CACHE_CHUNK : bits;
+            this->take(n);
+            bits -= n;
+        }
+        return true;
+    }
+
+    /**
+     * \brief Get the number of bits that haven't been read.
+     */
+    size_t remaining() const {
+        return (L - this->_pos) * 8 + this->_cacheBits;
+    }
+
+    /**
+     * \copydoc safearray::getBits
+     */
+    template<size_t Pos, size_t Width>
+    uint32_t get() const {
+        return getBits<Pos, Width, Order>(this->_data);
+    }
+
+private:
+    void refill() {
+        while (this->_cacheBits <= detail::BIT_CACHE_BITS - 8 && this->_pos < L) {
+            detail::BitCache b = this->_data[this->_pos++];
+            if (Order == BitOrder::MSB_FIRST) {
+                this->_cache |= b << (detail::BIT_CACHE_BITS - 8 - this->_cacheBits);
+            } else {
+                this->_cache |= b << this->_cacheBits;
+            }
+            this->_cacheBits += 8;
+        }
+    }
+
+    /**
+     * Take \c width (at most \c BIT_CACHE_CHUNK) bits that are known to
+     * be available.
+     */
+    uint32_t take(size_t width) {
+        if (width == 0) {
+            return 0;
+        }
+        if (this->_cacheBits < width) {
+            this->refill();
+        }
+        uint32_t v;
+        if (Order == BitOrder::MSB_FIRST) {
+            v = (uint32_t) (this->_cache >> (detail::BIT_CACHE_BITS - width));
+            this->_cache <<= width;
+        } else {
+            v = (uint32_t) this->_cache & detail::fieldMask(width);
+            this->_cache >>= width;
+        }
+        this->_cacheBits -= width;
+        return v;
+    }
+
+    CByteSlice<L> _data;
+    size_t _pos;
+    detail::BitCache _cache;
+    size_t _cacheBits;
+};
+
+/**
+ * \brief Writes fields of arbitrary bit widths one after another into a
+ * byte slice.
+ *
+ * \tparam L The number of bytes in the slice.
+ * \tparam Order How bits are packed into bytes.  Default: \c MSB_FIRST.
+ *
+ * Bits are collected in a word-sized cache and stored a whole byte at a
+ * time.  Call \c flush after the last field to store a final partial byte.
+ */
+template<size_t L, BitOrder Order = BitOrder::MSB_FIRST>
+class BitWriter
+{
+public:
+    /**
+     * \brief Make a writer that starts at the beginning of a slice.
+     */
+    explicit BitWriter(ByteSlice<L> data)
+        : _data(data), _pos(0), _cache(0), _cacheBits(0) {}
+
+    /**
+     * \brief Write the next field.
+     *
+     * \param width The number of bits in the field (at most 32).
+     * \param value The field's value.  Bits above \c width are ignored.
+     *
+     * \return \c false (and nothing is written) iff there isn't room for
+     * \c width more bits or \c width is too large.
+     */
+    bool write(size_t width, uint32_t value) {
+        if (width > 32 || width > this->remaining()) {
+            return false;
+        }
+        if (width > detail::BIT_CACHE_CHUNK) {
+            // too wide for the cache, so put it in two parts
+            size_t rest = width - 16;
+            if (Order == BitOrder::MSB_FIRST) {
+                this->put(rest, value >> 16);
+                this->put(16, value);
+            } else {
+                this->put(16, value);
+                this->put(rest, value >> 16);
+            }
+        } else {
+            this->put(width, value);
+        }
+        return true;
+    }
+
+    /**
+     * \brief Store any bits still in the cache, padding the last byte
+     * with zeros.
+     *
+     * \return The number of bytes written so far.
+     */
+    size_t flush() {
+        this->drain(1);
+        this->_cache = 0;
+        this->_cacheBits = 0;
+        return this->_pos;
+    }
+
+    /**
+     * \brief Get the number of bits that can still be written.
+     */
+    size_t remaining() const {
+        return (L - this->_pos) * 8 - this->_cacheBits;
+    }
+
+    /**
+     * \brief Write a field at a position known at compile-time, as
+     * \c safearray::setBits does.
+     *
+     * WARNING: Bits that are still in the cache will overwrite the field
+     * when they're stored, so use this only on bytes that have been flushed
+     * or that the writer won't reach.
+     */
+    template<size_t Pos, size_t Width>
+    void set(uint32_t value) {
+        setBits<Pos, Width, Order>(this->_data, value);
+    }
+
+private:
+    /**
+     * Store bytes from the cache while at least \c minBits bits are in it.
+     */
+    void drain(size_t minBits) {
+        while (this->_cacheBits >= minBits && this->_cacheBits > 0) {
+            unsigned char b;
+            if (Order == BitOrder::MSB_FIRST) {
+                b = (unsigned char) (this->_cache >> (detail::BIT_CACHE_BITS - 8));
+                this->_cache <<= 8;
+            } else {
+                b = (unsigned char) this->_cache;
+                this->_cache >>= 8;
+            }
+            this->_data[this->_pos++] = b;
+            this->_cacheBits = this->_cacheBits > 8 ? this->_cacheBits - 8 : 0;
+        }
+    }
+
+    /**
+     * Put \c width (at most \c BIT_CACHE_CHUNK) bits that are known to fit.
+     */
+    void put(size_t width, uint32_t value) {
+        if (width == 0) {
+            return;
+        }
+        detail::BitCache v = value & detail::fieldMask(width);
+        if (this->_cacheBits + width > detail::BIT_CACHE_BITS) {
+            this->drain(8);
+        }
+        if (Order == BitOrder::MSB_FIRST) {
+            this->_cache |= v << (detail::BIT_CACHE_BITS - this->_cacheBits - width);
+        } else {
+            this->_cache |= v << this->_cacheBits;
+        }
+        this->_cacheBits += width;
+    }
+
+    ByteSlice<L> _data;
+    size_t _pos;
+    detail::BitCache _cache;
+    size_t _cacheBits;
+};
+
+} // namespace safearray
+
+#endif
@@ -0,0 +1,365 @@
+#ifndef __MCU_SAFE_CBOR_H__
+#define __MCU_SAFE_CBOR_H__
+
+/**
+ * \file
+ *
+ * Encoding CBOR (RFC 8949) straight into a byte slice, with the worst-case
+ * size of each item checked against the room left at compile-time.
+ */
+
+#include "mcu_safe_string.h"
+
+namespace safearray {
+
+/**
+ * \brief The header of a CBOR array of \c N items, which must follow it.
+ */
+template<size_t N>
+struct CborArrayHeader {};
+
+/**
+ * \brief The header of a CBOR map of \c N key/value pairs, which must follow
+ * it as \c 2N items.
+ */
+template<size_t N>
+struct CborMapHeader {};
+
+/**
+ * \brief The CBOR \c null value.
+ */
+struct CborNull {};
+
+namespace detail {
+
+const unsigned char CBOR_UINT = 0x00;
+const unsigned char CBOR_NEGATIVE = 0x20;
+const unsigned char CBOR_BYTES = 0x40;
+const unsigned char CBOR_TEXT = 0x60;
+const unsigned char CBOR_ARRAY = 0x80;
+const unsigned char CBOR_MAP = 0xa0;
+const unsigned char CBOR_FALSE = 0xf4;
+const unsigned char CBOR_TRUE = 0xf5;
+const unsigned char CBOR_NULL = 0xf6;
+const unsigned char CBOR_FLOAT32 = 0xfa;
+const unsigned char CBOR_FLOAT64 = 0xfb;
+
+/**
+ * The size of the head of an item whose argument is \c n.
+ */
+constexpr size_t cborHeadSize(uint64_t n) {
+    return n < 24 ? 1 : n <= 0xff ? 2 : n <= 0xffff ? 3 : n <= 0xffffffffu ? 5 : 9;
+}
+
+template<typename U>
+unsigned char *cborBigEndian(unsigned char *p, U v, size_t bytes) {
+    for (size_t i = bytes; i-- > 0;) {
+        *p++ = (unsigned char) ((uint64_t) v >> (8 * i));
+    }
+    return p;
+}
+
+/**
+ * Write the head of an item, in the shortest form.  Comparisons that can't
+ * be true for a \c U are dropped at compile-time, so small types don't need
+ * 64-bit arithmetic.
+ */
+template<typename U>
+unsigned char *cborHead(unsigned char *p, unsigned char major, U arg) {
+    if (arg < 24) {
+        *p++ = (unsigned char) (major | arg);
+    } else if (sizeof(U) == 1 || arg <= 0xff) {
+        *p++ = major | 24;
+        *p++ = (unsigned char) arg;
+    } else if (sizeof(U) == 2 || arg <= 0xffff) {
+        *p++ = major | 25;
+        p = cborBigEndian(p, arg, 2);
+    } else if (sizeof(U) == 4 || arg <= 0xffffffffu) {
+        *p++ = major | 26;
+        p = cborBigEndian(p, arg, 4);
+    } else {
+        *p++ = major | 27;
+        p = cborBigEndian(p, arg, 8);
+    }
+    return p;
+}
+
+/**
+ * How a \c T is encoded as one CBOR item.  \c MAX_SIZE is the most bytes
+ * that \c write can produce.
+ */
+template<typename T>
+struct CborItem;
+
+template<typename U>
+struct CborUIntItem {
+    static constexpr size_t MAX_SIZE = 1 + sizeof(U);
+
+    static unsigned char *write(unsigned char *p, U v) {
+        return cborHead(p, CBOR_UINT, v);
+    }
+};
+
+template<typename I, typename U>
+struct CborIntItem {
+    static constexpr size_t MAX_SIZE = 1 + sizeof(I);
+
+    static unsigned char *write(unsigned char *p, I v) {
+        // A negative v is stored as -1 - v, which is ~v.
+        return v < 0 ? cborHead(p, CBOR_NEGATIVE, (U) ~(U) v) : cborHead(p, CBOR_UINT, (U) v);
+    }
+};
+
+template<> struct CborItem<unsigned char> : CborUIntItem<unsigned char> {};
+template<> struct CborItem<unsigned short> : CborUIntItem<unsigned short> {};
+template<> struct CborItem<unsigned int> : CborUIntItem<unsigned int> {};
+template<> struct CborItem<unsigned long> : CborUIntItem<unsigned long> {};
+template<> struct CborItem<unsigned long long> : CborUIntItem<unsigned long long> {};
+template<> struct CborItem<signed char> : CborIntItem<signed char, unsigned char> {};
+template<> struct CborItem<short> : CborIntItem<short, unsigned short> {};
+template<> struct CborItem<int> : CborIntItem<int, unsigned int> {};
+template<> struct CborItem<long> : CborIntItem<long, unsigned long> {};
+template<> struct CborItem<long long> : CborIntItem<long long, unsigned long long> {};
+
+template<>
+struct CborItem<bool> {
+    static constexpr size_t MAX_SIZE = 1;
+
+    static unsigned char *write(unsigned char *p, bool v) {
+        *p++ = v ? CBOR_TRUE : CBOR_FALSE;
+        return p;
+    }
+};
+
+template<>
+struct CborItem<CborNull> {
+    static constexpr size_t MAX_SIZE = 1;
+
+    static unsigned char *write(unsigned char *p, CborNull) {
+        *p++ = CBOR_NULL;
+        return p;
+    }
+};
+
+template<>
+struct CborItem<float> {
+    static constexpr size_t MAX_SIZE = 5;
+
+    static unsigned char *write(unsigned char *p, float v) {
+        uint32_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        *p++ = CBOR_FLOAT32;
+        return cborBigEndian(p, bits, 4);
+    }
+};
+
+/**
+ * On AVR, \c double is the same as \c float, so it's encoded the same way.
+ */
+template<>
+struct CborItem<double> {
+    static constexpr size_t MAX_SIZE = sizeof(double) == 8 ? 9 : 5;
+
+    static unsigned char *write(unsigned char *p, double v) {
+        if (sizeof(double) != 8) {
+            return CborItem<float>::write(p, (float) v);
+        }
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        *p++ = CBOR_FLOAT64;
+        return cborBigEndian(p, bits, 8);
+    }
+};
+
+template<size_t N>
+struct CborItem<CborArrayHeader<N> > {
+    static constexpr size_t MAX_SIZE = cborHeadSize(N);
+
+    static unsigned char *write(unsigned char *p, CborArrayHeader<N>) {
+        return cborHead(p, CBOR_ARRAY, (uint64_t) N);
+    }
+};
+
+template<size_t N>
+struct CborItem<CborMapHeader<N> > {
+    static constexpr size_t MAX_SIZE = cborHeadSize(N);
+
+    static unsigned char *write(unsigned char *p, CborMapHeader<N>) {
+        return cborHead(p, CBOR_MAP, (uint64_t) N);
+    }
+};
+
+/**
+ * A string or byte string whose length is known at compile-time.
+ */
+template<unsigned char Major, size_t L>
+struct CborStringItem {
+    static constexpr size_t MAX_SIZE = cborHeadSize(L) + L;
+
+    static unsigned char *write(unsigned char *p, const void *data) {
+        p = cborHead(p, Major, (uint64_t) L);
+        memcpy(p, data, L);
+        return p + L;
+    }
+};
+
+template<size_t L>
+struct CborItem<CSlice<char, L> > : CborStringItem<CBOR_TEXT, L> {
+    static unsigned char *write(unsigned char *p, CSlice<char, L> s) {
+        return CborStringItem<CBOR_TEXT, L>::write(p, s.cdata());
+    }
+};
+
+template<size_t L>
+struct CborItem<Slice<char, L> > : CborItem<CSlice<char, L> > {};
+
+/**
+ * String literals are encoded without their \c NUL.
+ */
+template<size_t N>
+struct CborItem<char[N]> : CborStringItem<CBOR_TEXT, N - 1> {
+    static unsigned char *write(unsigned char *p, const char (&s)[N]) {
+        return CborStringItem<CBOR_TEXT, N - 1>::write(p, s);
+    }
+};
+
+template<size_t L>
+struct CborItem<CSlice<unsigned char, L> > : CborStringItem<CBOR_BYTES, L> {
+    static unsigned char *write(unsigned char *p, CSlice<unsigned char, L> s) {
+        return CborStringItem<CBOR_BYTES, L>::write(p, s.cdata());
+    }
+};
+
+template<size_t L>
+struct CborItem<Slice<unsigned char, L> > : CborItem<CSlice<unsigned char, L> > {};
+
+/**
+ * A \c FixedString's length is only known at runtime, so the worst case is
+ * a full one.
+ */
+template<size_t N>
+struct CborItem<FixedString<N> > {
+    static constexpr size_t MAX_SIZE = cborHeadSize(N) + N;
+
+    static unsigned char *write(unsigned char *p, const FixedString<N>& s) {
+        p = cborHead(p, CBOR_TEXT, (uint64_t) s.size());
+        memcpy(p, s.c_str(), s.size());
+        return p + s.size();
+    }
+};
+
+} // namespace detail
+
+/**
+ * \brief The maximum number of bytes that CBOR items of the given types
+ * take up, for sizing a buffer for a message whose schema is fixed.
+ *
+ * \code
+ * typedef safearray::CborMaxSize<safearray::CborMapHeader<2>,
+ *                                char[5], uint32_t, char[5], float> Telemetry;
+ * safearray::ByteArray<Telemetry::value> msg;
+ * \endcode
+ */
+template<typename... Ts>
+struct CborMaxSize {
+    static constexpr size_t value = detail::sum(detail::CborItem<Ts>::MAX_SIZE...);
+};
+
+template<typename... Ts>
+constexpr size_t CborMaxSize<Ts...>::value;
+
+/**
+ * \brief Writes CBOR items one after another into a byte slice.
+ *
+ * \tparam R The number of bytes that are certainly still free.
+ *
+ * Each item is written in its shortest form, so the actual position is
+ * only known at runtime.  But writing an item returns a writer whose \c R
+ * is smaller by the item's worst-case size, which is statically checked
+ * against \c R.  So no room is checked at runtime, and a message that might
+ * not fit doesn't compile.
+ *
+ * \code
+ * safearray::ByteArray<32> msg;
+ * auto end = safearray::cborWriter(msg)
+ *     << safearray::CborMapHeader<2>()
+ *     << "seq" << seq
+ *     << "temp" << temperature;
+ * send(end.written());
+ * \endcode
+ *
+ * Supported items are integers, \c bool, \c float, \c double, \c CborNull,
+ * array and map headers, string literals, \c FixedStrings, and slices of
+ * \c char (text) and \c unsigned \c char (byte strings).
+ */
+template<size_t R>
+class CborWriter
+{
+public:
+    /**
+     * \brief Make a writer that starts at the beginning of a slice.
+     */
+    explicit CborWriter(ByteSlice<R> data) : _start(data.data()), _pos(data.data()) {}
+
+    /**
+     * \brief Write an item.
+     *
+     * \return A writer that's positioned after the item.
+     */
+    template<typename T>
+    CborWriter<R - detail::CborItem<T>::MAX_SIZE> operator<<(const T& item) const {
+        static_assert(detail::CborItem<T>::MAX_SIZE <= R, "Destination too short");
+        return CborWriter<R - detail::CborItem<T>::MAX_SIZE>(
+            this->_start, detail::CborItem<T>::write(this->_pos, item));
+    }
+
+    /**
+     * \brief Get the number of bytes written so far.
+     */
+    size_t size() const {
+        return this->_pos - this->_start;
+    }
+
+    /**
+     * \brief Make a pointer to the bytes written so far.
+     */
+    CByteArrayPtr written() const {
+        return CByteArrayPtr(this->_start, this->size());
+    }
+
+    /**
+     * \brief Make a slice of the bytes that are certainly still free,
+     * starting where the next item would go.
+     */
+    ByteSlice<R> remaining() const {
+        return ByteSlice<R>(this->_pos);
+    }
+
+private:
+    template<size_t> friend class CborWriter;
+
+    CborWriter(unsigned char *start, unsigned char *pos) : _start(start), _pos(pos) {}
+
+    unsigned char *_start;
+    unsigned char *_pos;
+};
+
+/**
+ * \brief Make a \c CborWriter that starts at the beginning of a slice.
+ */
+template<size_t L>
+CborWriter<L> cborWriter(ByteSlice<L> dest) {
+    return CborWriter<L>(dest);
+}
+
+/**
+ * \copydoc cborWriter(ByteSlice<L>)
+ */
+template<size_t L>
+CborWriter<L> cborWriter(ByteArray<L>& dest) {
+    return CborWriter<L>(dest.slice());
+}
+
+} // namespace safearray
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef __MCU_SAFE_CHECKSUM_H__
+#define __MCU_SAFE_CHECKSUM_H__
+
+/**
+ * \file
+ *
+ * Checksums that can be computed while the data is copied, so that
+ * building a frame and checksumming it take one pass instead of two.
+ *
+ * CRCs are in \c mcu_safe_crc.h and work the same way.
+ */
+
+#include "mcu_safe_array.h"
+
+namespace safearray {
+
+/**
+ * \brief The operations shared by all checksums.
+ *
+ * \tparam Derived The checksum class.  It must have a method
+ * <tt>template<bool Copy> void process(unsigned char *dest,
+ * const unsigned char *src, size_t n)</tt> that adds \c n bytes from \c src
+ * to the checksum and, iff \c Copy, also copies them to \c dest.
+ */
+template<typename Derived>
+class Checksum
+{
+public:
+    /**
+     * \brief Add a byte to the checksum.
+     */
+    void update(unsigned char b) {
+        this->self().template process<false>(nullptr, &b, 1);
+    }
+
+    /**
+     * \brief Add bytes to the checksum.
+     *
+     * This can be called several times to checksum data that arrives in
+     * chunks.
+     */
+    template<size_t L>
+    void update(CByteSlice<L> data) {
+        this->self().template process<false>(nullptr, data.cdata(), L);
+    }
+
+    /**
+     * \copydoc Checksum::update(CByteSlice<L>)
+     */
+    void update(CByteArrayPtr data) {
+        this->self().template process<false>(nullptr, data.data(), data.size());
+    }
+
+    /**
+     * \brief Copy bytes to the beginning of a slice and add them to the
+     * checksum, in one pass.
+     *
+     * \param dest The slice to copy to.  Its length is statically checked
+     * against the length of \c src.
+     * \param src The bytes to copy.
+     *
+     * \return A slice pointing to the section of \c dest that wasn't written
+     * to.
+     */
+    template<size_t L1, size_t L2>
+    ByteSlice<L1 - L2> copy(ByteSlice<L1> dest, CByteSlice<L2> src) {
+        static_assert(L2 <= L1, "Bad source length");
+        this->self().template process<true>(dest.data(), src.cdata(), L2);
+        return dest.template slice<L2>();
+    }
+
+private:
+    Derived& self() {
+        return static_cast<Derived&>(*this);
+    }
+};
+
+/**
+ * \brief Fletcher's 16-bit checksum.
+ *
+ * Much cheaper than a CRC on MCUs without a barrel shifter, but it doesn't
+ * detect as many errors.
+ */
+class Fletcher16 : public Checksum<Fletcher16>
+{
+public:
+    /**
+     * \brief Start a new checksum.
+     */
+    Fletcher16() : _sum1(0), _sum2(0) {}
+
+    /**
+     * \brief Start over.
+     */
+    void reset() {
+        this->_sum1 = 0;
+        this->_sum2 = 0;
+    }
+
+    /**
+     * \brief Get the checksum of the bytes added so far.
+     */
+    uint16_t value() const {
+        return (uint16_t) (this->_sum2 << 8 | this->_sum1);
+    }
+
+    /**
+     * \brief The kernel behind the methods of \c Checksum.
+     */
+    template<bool Copy>
+    void process(unsigned char *dest, const unsigned char *src, size_t n) {
+        uint32_t sum1 = this->_sum1;
+        uint32_t sum2 = this->_sum2;
+        while (n > 0) {
+            // The most bytes that can be summed before sum2 overflows.
+            size_t block = n < 5802 ? n : 5802;
+            n -= block;
+            for (size_t i = 0; i < block; ++i) {
+                unsigned char b = src[i];
+                if (Copy) {
+                    dest[i] = b;
+                }
+                sum1 += b;
+                sum2 += sum1;
+            }
+            src += block;
+            dest += Copy ? block : 0;
+            sum1 %= 255;
+            sum2 %= 255;
+        }
+        this->_sum1 = (uint8_t) sum1;
+        this->_sum2 = (uint8_t) sum2;
+    }
+
+private:
+    uint8_t _sum1;
+    uint8_t _sum2;
+};
+
+/**
+ * \brief The Adler-32 checksum, as used by zlib.
+ */
+class Adler32 : public Checksum<Adler32>
+{
+public:
+    /**
+     * \brief Start a new checksum.
+     */
+    Adler32() : _a(1), _b(0) {}
+
+    /**
+     * \copydoc Fletcher16::reset
+     */
+    void reset() {
+        this->_a = 1;
+        this->_b = 0;
+    }
+
+    /**
+     * \copydoc Fletcher16::value
+     */
+    uint32_t value() const {
+        return this->_b << 16 | this->_a;
+    }
+
+    /**
+     * \brief The kernel behind the methods of \c Checksum.
+     */
+    template<bool Copy>
+    void process(unsigned char *dest, const unsigned char *src, size_t n) {
+        uint32_t a = this->_a;
+        uint32_t b = this->_b;
+        while (n > 0) {
+            // The most bytes that can be summed before b overflows.
+            size_t block = n < 5552 ? n : 5552;
+            n -= block;
+            for (size_t i = 0; i < block; ++i) {
+                unsigned char c = src[i];
+                if (Copy) {
+                    dest[i] = c;
+                }
+                a += c;
+                b += a;
+            }
+            src += block;
+            dest += Copy ? block : 0;
+            a %= 65521;
+            b %= 65521;
+        }
+        this->_a = a;
+        this->_b = b;
+    }
+
+private:
+    uint32_t _a;
+    uint32_t _b;
+};
+
+/**
+ * \brief Bytes to be checksummed as they're copied with \c operator<<.
+ *
+ * Made with \c safearray::checksummed().
+ */
+template<typename S, size_t L>
+struct Checksummed
+{
+    CByteSlice<L> data;
+    S& sum;
+};
+
+/**
+ * \brief Wrap bytes so that \c operator<< adds them to a checksum while
+ * copying them.
+ *
+ * \code
+ * safearray::Crc16Ccitt crc;
+ * auto rest = frame << header.cslice()
+ *                   << safearray::checksummed(payload.cslice(), crc);
+ * rest[0] = (unsigned char) (crc.value() >> 8);
+ * rest[1] = (unsigned char) crc.value();
+ * \endcode
+ *
+ * \param data The bytes to copy.
+ * \param sum The checksum to add them to.
+ */
+template<typename S, size_t L>
+Checksummed<S, L> checksummed(CByteSlice<L> data, S& sum) {
+    return Checksummed<S, L>{data, sum};
+}
+
+/**
+ * \brief Copy bytes to the beginning of a slice and add them to a checksum,
+ * in one pass.
+ *
+ * \param dest The slice to copy to.  Its length is statically checked
+ * against the length of \c src.
+ * \param src The bytes to copy.
+ * \param sum The checksum to add them to.
+ *
+ * \return A slice pointing to the section of \c dest that wasn't written to.
+ */
+template<typename S, size_t L1, size_t L2>
+ByteSlice<L1 - L2> assignWithChecksum(ByteSlice<L1> dest, CByteSlice<L2> src, S& sum) {
+    return sum.copy(dest, src);
+}
+
+/**
+ * \copydoc safearray::assignWithChecksum(ByteSlice<L1>, CByteSlice<L2>, S&)
+ */
+template<typename S, size_t L1, size_t L2>
+ByteSlice<L1 - L2> assignWithChecksum(ByteArray<L1>& dest, CByteSlice<L2> src, S& sum) {
+    return sum.copy(dest.slice(), src);
+}
+
+/**
+ * \brief Copy bytes to the beginning of a slice and add them to a checksum,
+ * in one pass.
+ *
+ * \return A slice pointing to the section of the destination slice that
+ * wasn't written to.
+ */
+template<typename S, size_t L1, size_t L2>
+ByteSlice<L1 - L2> operator<<(ByteSlice<L1> dest, Checksummed<S, L2> data) {
+    return data.sum.copy(dest, data.data);
+}
+
+/**
+ * \copydoc safearray::operator<<(ByteSlice<L1>, Checksummed<S, L2>)
+ */
+template<typename S, size_t L1, size_t L2>
+ByteSlice<L1 - L2> operator<<(ByteArray<L1>& dest, Checksummed<S, L2> data) {
+    return data.sum.copy(dest.slice(), data.data);
+}
+
+} // namespace safearray
+
+#endif
@@ -0,0 +1,577 @@
+#ifndef __MCU_SAFE_CRC_H__
+#define __MCU_SAFE_CRC_H__
+
+/**
+ * \file
+ *
+ * Cyclic redundancy checks with any polynomial and width up to 64 bits.
+ */
+
+#include "mcu_safe_checksum.h"
+
+namespace safearray {
+
+/**
+ * \brief Compute the CRC a bit at a time.  Slowest, but needs no table.
+ */
+struct CrcBitwise {};
+
+/**
+ * \brief Compute the CRC four bits at a time with a 16-entry table.
+ *
+ * A good trade-off on MCUs with little memory.
+ */
+struct CrcNibbleTable {};
+
+/**
+ * \brief Compute the CRC a byte at a time with a 256-entry table.
+ */
+struct CrcByteTable {};
+
+/**
+ * \brief Compute the CRC \c N bytes at a time with \c N 256-entry tables.
+ *
+ * Fastest on CPUs with a large data cache, since the lookups for the \c N
+ * bytes don't depend on each other.
+ *
+ * \tparam N The number of bytes per step, from \c 2 to \c 8.
+ */
+template<size_t N>
+struct CrcSliceBy {};
+
+/**
+ * Slice-by-4.
+ */
+typedef CrcSliceBy<4> CrcSliceBy4;
+
+/**
+ * Slice-by-8.
+ */
+typedef CrcSliceBy<8> CrcSliceBy8;
+
+namespace detail {
+
+/**
+ * The smallest unsigned type that holds a \c Width -bit CRC.
+ */
+template<size_t Width, bool Fits8 = (Width <= 8), bool Fits16 = (Width <= 16),
+    bool Fits32 = (Width <= 32)>
+struct CrcUInt { typedef uint64_t type; };
+template<size_t Width, bool Fits16, bool Fits32>
+struct CrcUInt<Width, true, Fits16, Fits32> { typedef uint8_t type; };
+template<size_t Width, bool Fits32>
+struct CrcUInt<Width, false, true, Fits32> { typedef uint16_t type; };
+template<size_t Width>
+struct CrcUInt<Width, false, false, true> { typedef uint32_t type; };
+
+constexpr uint64_t crcMask(size_t width) {
+    return width == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << width) - 1;
+}
+
+/**
+ * Reverse the lowest \c width bits of \c v.
+ */
+constexpr uint64_t reflect(uint64_t v, size_t width) {
+    return width == 0 ? 0 : ((v & 1) << (width - 1)) | reflect(v >> 1, width - 1);
+}
+
+/**
+ * \c v shifted right by \c s bits, or \c 0 if \c s is too big.
+ */
+constexpr uint64_t shiftRight(uint64_t v, size_t s) {
+    return s >= 64 ? 0 : v >> s;
+}
+
+/**
+ * \c v shifted left by \c s bits, or \c 0 if \c s is too big.
+ */
+constexpr uint64_t shiftLeft(uint64_t v, size_t s) {
+    return s >= 64 ? 0 : v << s;
+}
+
+/**
+ * The type to do shifts in, so that small registers aren't promoted to
+ * (signed) \c int or widened to 64 bits.
+ */
+template<typename U>
+struct CrcWork {
+    typedef decltype(U(0) + 0u) type;
+};
+
+/*
+ * Everything below works on the CRC register in an internal form that is at
+ * least 8 bits wide, so that whole bytes can be fed to it.  A reflected CRC
+ * narrower than 8 bits just has high bits that stay 0.  A normal one is
+ * shifted left, along with its polynomial, to fill the byte.
+ */
+
+/**
+ * Feed \c n zero bits to the register \c reg.
+ */
+constexpr uint64_t crcSteps(uint64_t reg, size_t n, size_t width, bool reflected,
+                            uint64_t poly) {
+    return n == 0 ? reg : crcSteps(
+        reflected
+            ? ((reg & 1) ? (reg >> 1) ^ poly : reg >> 1)
+            : (((reg >> (width - 1)) & 1)
+                ? ((reg << 1) & crcMask(width)) ^ poly
+                : (reg << 1) & crcMask(width)),
+        n - 1, width, reflected, poly);
+}
+
+/**
+ * The table entry for the \c bits -bit chunk \c i, i.e., the register after
+ * feeding it \c i when it starts at \c 0.
+ */
+constexpr uint64_t crcBase(uint64_t i, size_t bits, size_t width, bool reflected,
+                           uint64_t poly) {
+    return crcSteps(reflected ? i : i << (width - bits), bits, width, reflected, poly);
+}
+
+/**
+ * Feed a zero byte to a register whose value is a table entry.
+ */
+constexpr uint64_t crcNextSlice(uint64_t v, size_t width, bool reflected, uint64_t poly) {
+    return reflected
+        ? (v >> 8) ^ crcBase(v & 0xff, 8, width, reflected, poly)
+        : (shiftLeft(v, 8) & crcMask(width)) ^ crcBase(v >> (width - 8), 8, width, reflected, poly);
+}
+
+/**
+ * Entry \c i of slice table \c k, i.e., the register after feeding it byte
+ * \c i followed by \c k zero bytes.
+ */
+constexpr uint64_t crcSliceEntry(size_t k, uint64_t i, size_t width, bool reflected,
+                                 uint64_t poly) {
+    return k == 0
+        ? crcBase(i, 8, width, reflected, poly)
+        : crcNextSlice(crcSliceEntry(k - 1, i, width, reflected, poly), width, reflected, poly);
+}
+
+/**
+ * Multiply two polynomials modulo the generator \c poly, all in normal
+ * form.
+ */
+inline uint64_t crcMulMod(uint64_t a, uint64_t b, size_t width, uint64_t poly) {
+    uint64_t prod = 0;
+    for (size_t i = width; i > 0; --i) {
+        bool top = ((prod >> (width - 1)) & 1) != 0;
+        prod = (prod << 1) & crcMask(width);
+        if (top) {
+            prod ^= poly;
+        }
+        if ((a >> (i - 1)) & 1) {
+            prod ^= b;
+        }
+    }
+    return prod;
+}
+
+/**
+ * Compute \c x^(8n) modulo the generator \c poly, in normal form, by
+ * repeated squaring.
+ */
+inline uint64_t crcXPow8N(uint64_t n, size_t width, uint64_t poly) {
+    // x^8 mod poly.
+    uint64_t base = 1;
+    for (int i = 0; i < 8; ++i) {
+        bool top = ((base >> (width - 1)) & 1) != 0;
+        base = (base << 1) & crcMask(width);
+        if (top) {
+            base ^= poly;
+        }
+    }
+    uint64_t result = 1;
+    for (; n > 0; n >>= 1) {
+        if (n & 1) {
+            result = crcMulMod(result, base, width, poly);
+        }
+        base = crcMulMod(base, base, width, poly);
+    }
+    return result;
+}
+
+/**
+ * \c K lookup tables of \c 2^Bits entries each, stored one after the other
+ * and generated at compile-time.
+ */
+template<typename U, size_t Width, bool Reflected, uint64_t Poly, size_t Bits, size_t K,
+    typename Is = typename MakeIndices<((size_t) 1 << Bits) * K>::type>
+struct CrcTable;
+
+template<typename U, size_t Width, bool Reflected, uint64_t Poly, size_t Bits, size_t K,
+    size_t... Is>
+struct CrcTable<U, Width, Reflected, Poly, Bits, K, Indices<Is...> > {
+    static constexpr Array<U, sizeof...(Is)> table = {{
+        (U) (Bits == 8
+            ? crcSliceEntry(Is >> 8, Is & 0xff, Width, Reflected, Poly)
+            : crcBase(Is, Bits, Width, Reflected, Poly))...
+    }};
+};
+
+template<typename U, size_t Width, bool Reflected, uint64_t Poly, size_t Bits, size_t K,
+    size_t... Is>
+constexpr Array<U, sizeof...(Is)>
+    CrcTable<U, Width, Reflected, Poly, Bits, K, Indices<Is...> >::table SAFEARRAY_PROGMEM;
+
+/**
+ * Read an entry of a table in \c SAFEARRAY_PROGMEM.  Entries that are wider
+ * or narrower than the read macros are put back together in memory order,
+ * so the byte order of the CPU doesn't matter.
+ */
+template<typename U, size_t Size = sizeof(U)>
+struct CrcTableRead;
+
+template<typename U>
+struct CrcTableRead<U, 1> {
+    static U read(const U *p) {
+        return (U) SAFEARRAY_READ_PROGMEM_BYTE(p);
+    }
+};
+
+template<typename U>
+struct CrcTableRead<U, 2> {
+    static U read(const U *p) {
+        const uint8_t *b = (const uint8_t *) p;
+        uint8_t bytes[2] = { SAFEARRAY_READ_PROGMEM_BYTE(b), SAFEARRAY_READ_PROGMEM_BYTE(b + 1) };
+        U v;
+        memcpy(&v, bytes, sizeof(v));
+        return v;
+    }
+};
+
+template<typename U>
+struct CrcTableRead<U, 4> {
+    static U read(const U *p) {
+        return (U) SAFEARRAY_READ_PROGMEM_DWORD(p);
+    }
+};
+
+template<typename U>
+struct CrcTableRead<U, 8> {
+    static U read(const U *p) {
+        const uint32_t *w = (const uint32_t *) p;
+        uint32_t words[2] = { SAFEARRAY_READ_PROGMEM_DWORD(w), SAFEARRAY_READ_PROGMEM_DWORD(w + 1) };
+        U v;
+        memcpy(&v, words, sizeof(v));
+        return v;
+    }
+};
+
+template<typename U>
+U crcTableEntry(const U *table, size_t i) {
+    return CrcTableRead<U>::read(table + i);
+}
+
+/**
+ * Feed \c n bytes from \c src to the register \c reg, copying them to
+ * \c dest iff \c Copy, and return the new register.
+ */
+template<typename Policy, typename U, size_t Width, bool Reflected, uint64_t Poly>
+struct CrcKernel;
+
+template<typename U, size_t Width, bool Reflected, uint64_t Poly>
+struct CrcKernel<CrcBitwise, U, Width, Reflected, Poly> {
+    typedef typename CrcWork<U>::type V;
+
+    template<bool Copy>
+    static U run(U reg, unsigned char *dest, const unsigned char *src, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            unsigned char b = src[i];
+            if (Copy) {
+                dest[i] = b;
+            }
+            if (Reflected) {
+                reg ^= b;
+            } else {
+                reg ^= (U) ((V) b << (Width - 8));
+            }
+            for (int k = 0; k < 8; ++k) {
+                bool bit = ((Reflected ? reg : reg >> (Width - 1)) & 1) != 0;
+                if (Reflected) {
+                    reg = (U) ((V) reg >> 1);
+                } else {
+                    reg = (U) (((V) reg << 1) & (V) (U) crcMask(Width));
+                }
+                if (bit) {
+                    reg ^= (U) Poly;
+                }
+            }
+        }
+        return reg;
+    }
+};
+
+template<typename U, size_t Width, bool Reflected, uint64_t Poly>
+struct CrcKernel<CrcNibbleTable, U, Width, Reflected, Poly> {
+    typedef CrcTable<U, Width, Reflected, Poly, 4, 1> Table;
+
+    typedef typename CrcWork<U>::type V;
+
+    static U nibble(U reg, unsigned nib) {
+        const U *table = Table::table.cdata();
+        if (Reflected) {
+            return (U) (((V) reg >> 4) ^ crcTableEntry(table, (reg ^ nib) & 0xf));
+        }
+        return (U) ((((V) reg << 4) & (V) (U) crcMask(Width))
+                    ^ crcTableEntry(table, ((reg >> (Width - 4)) ^ nib) & 0xf));
+    }
+
+    template<bool Copy>
+    static U run(U reg, unsigned char *dest, const unsigned char *src, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            unsigned char b = src[i];
+            if (Copy) {
+                dest[i] = b;
+            }
+            if (Reflected) {
+                reg = nibble(nibble(reg, b & 0xf), b >> 4);
+            } else {
+                reg = nibble(nibble(reg, b >> 4), b & 0xf);
+            }
+        }
+        return reg;
+    }
+};
+
+template<typename U, size_t Width, bool Reflected, uint64_t Poly, size_t K>
+struct CrcSliceKernel {
+    static_assert(K >= 1 && K <= 8, "Bad slice count");
+
+    typedef CrcTable<U, Width, Reflected, Poly, 8, K> Table;
+
+    typedef typename CrcWork<U>::type V;
+
+    static U byte(U reg, unsigned char b) {
+        const U *table = Table::table.cdata();
+        if (Reflected) {
+            return (U) (((V) reg >> 8) ^ crcTableEntry(table, (reg ^ b) & 0xff));
+        }
+        return (U) ((((V) reg << 8) & (V) (U) crcMask(Width))
+                    ^ crcTableEntry(table, ((reg >> (Width - 8)) ^ b) & 0xff));
+    }
+
+    template<bool Copy>
+    static U run(U reg, unsigned char *dest, const unsigned char *src, size_t n) {
+        const U *table = Table::table.cdata();
+        for (; K > 1 && n >= K; n -= K) {
+            // Load the K bytes into one word, in the order the CRC consumes
+            // them, and combine it with the register.
+            uint64_t word = 0;
+            for (size_t j = 0; j < K; ++j) {
+                word |= shiftLeft(src[j], Reflected ? 8 * j : 8 * (K - 1 - j));
+            }
+            if (Copy) {
+                memcpy(dest, src, K);
+            }
+            U acc;
+            if (Reflected) {
+                word ^= reg;
+                acc = (U) shiftRight(reg, 8 * K);
+            } else if (Width <= 8 * K) {
+                word ^= shiftLeft(reg, 8 * K - Width);
+                acc = 0;
+            } else {
+                word ^= shiftRight(reg, Width - 8 * K);
+                acc = (U) (shiftLeft(reg, 8 * K) & crcMask(Width));
+            }
+            for (size_t j = 0; j < K; ++j) {
+                size_t byteShift = Reflected ? 8 * j : 8 * (K - 1 - j);
+                acc ^= crcTableEntry(table, (K - 1 - j) * 256 + (shiftRight(word, byteShift) & 0xff));
+            }
+            reg = acc;
+            src += K;
+            dest += Copy ? K : 0;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            unsigned char b = src[i];
+            if (Copy) {
+                dest[i] = b;
+            }
+            reg = byte(reg, b);
+        }
+        return reg;
+    }
+};
+
+template<typename U, size_t Width, bool Reflected, uint64_t Poly>
+struct CrcKernel<CrcByteTable, U, Width, Reflected, Poly>
+    : CrcSliceKernel<U, Width, Reflected, Poly, 1> {};
+
+template<size_t N, typename U, size_t Width, bool Reflected, uint64_t Poly>
+struct CrcKernel<CrcSliceBy<N>, U, Width, Reflected, Poly>
+    : CrcSliceKernel<U, Width, Reflected, Poly, N> {};
+
+} // namespace detail
+
+/**
+ * \brief A cyclic redundancy check.
+ *
+ * \tparam Width The number of bits in the CRC.  Must be \c <= \c 64.
+ * \tparam Poly The generator polynomial, without the top bit, in normal
+ * (not reversed) form.
+ * \tparam Init The initial value of the register, in normal form.
+ * \tparam Reflected \c true iff bytes are processed least-significant bit
+ * first (and the result is reflected too).
+ * \tparam XorOut The value XORed with the register to give the result.
+ * \tparam Policy How to trade memory for speed: \c CrcBitwise (the
+ * default), \c CrcNibbleTable, \c CrcByteTable, \c CrcSliceBy4 or
+ * \c CrcSliceBy8.
+ *
+ * The parameters follow the usual "Rocksoft" model, with the restriction
+ * that input and output are either both reflected or both not, which covers
+ * nearly all CRCs in use.  Common ones have typedefs, e.g.,
+ * \c safearray::Crc16Ccitt and \c safearray::Crc32, and \c WithPolicy
+ * picks a different policy for them:
+ *
+ * \code
+ * safearray::Crc32::WithPolicy<safearray::CrcSliceBy8> crc;
+ * while (readChunk(chunk)) {
+ *     crc.update(&chunk);
+ * }
+ * uint32_t result = crc.value();
+ * \endcode
+ *
+ * Tables are generated at compile-time as \c Arrays, for any polynomial and
+ * width, and kept in flash on AVR.
+ */
+template<size_t Width, uint64_t Poly, uint64_t Init, bool Reflected, uint64_t XorOut,
+    typename Policy = CrcBitwise>
+class Crc : public Checksum<Crc<Width, Poly, Init, Reflected, XorOut, Policy> >
+{
+public:
+    static_assert(Width > 0 && Width <= 64, "Bad CRC width");
+
+    /**
+     * The type of the CRC's value.
+     */
+    typedef typename detail::CrcUInt<Width>::type value_type;
+
+    /**
+     * The same CRC, computed with a different policy.
+     */
+    template<typename P>
+    using WithPolicy = Crc<Width, Poly, Init, Reflected, XorOut, P>;
+
+    /**
+     * \brief Start a new CRC.
+     */
+    Crc() : _reg(INIT) {}
+
+    /**
+     * \brief Start over.
+     */
+    void reset() {
+        this->_reg = INIT;
+    }
+
+    /**
+     * \brief Get the CRC of the bytes added so far.
+     */
+    value_type value() const {
+        return (value_type) (((this->_reg >> SHIFT) ^ XorOut) & MASK);
+    }
+
+    /**
+     * \copydoc Fletcher16::process
+     */
+    template<bool Copy>
+    void process(unsigned char *dest, const unsigned char *src, size_t n) {
+        this->_reg = Kernel::template run<Copy>(this->_reg, dest, src, n);
+    }
+
+    /**
+     * \brief Compute the CRC of two pieces of data, one after the other,
+     * from the CRCs of the pieces.
+     *
+     * This lets a big buffer be split into chunks that are checksummed
+     * separately, e.g., on different threads.  It takes time proportional
+     * to the logarithm of \c lengthB.
+     *
+     * \param crcA The CRC of the first piece.
+     * \param crcB The CRC of the second piece.
+     * \param lengthB The number of bytes in the second piece.
+     *
+     * \return The CRC of the first piece followed by the second.
+     */
+    static value_type combine(value_type crcA, value_type crcB, uint64_t lengthB) {
+        // With the register as a polynomial, feeding it the second piece
+        // multiplies its starting value by x^(8 * lengthB) and adds a term
+        // that depends only on the data.  So swapping the starting value
+        // Init for the first piece's register adds (regA + Init) times
+        // x^(8 * lengthB).
+        uint64_t regA = toNormal((crcA ^ XorOut) & MASK);
+        uint64_t regB = toNormal((crcB ^ XorOut) & MASK);
+        uint64_t poly = Poly & MASK;
+        uint64_t shift = detail::crcXPow8N(lengthB, Width, poly);
+        uint64_t reg = detail::crcMulMod(regA ^ (Init & MASK), shift, Width, poly) ^ regB;
+        return (value_type) (toNormal(reg) ^ (XorOut & MASK));
+    }
+
+private:
+    // The internal form of the register described in detail.
+    static constexpr size_t REG_WIDTH = Width < 8 ? 8 : Width;
+    static constexpr size_t SHIFT = Reflected ? 0 : REG_WIDTH - Width;
+    static constexpr uint64_t MASK = detail::crcMask(Width);
+    static constexpr uint64_t POLY =
+        Reflected ? detail::reflect(Poly, Width) : (Poly & MASK) << SHIFT;
+    static constexpr value_type INIT = (value_type)
+        (Reflected ? detail::reflect(Init, Width) : (Init & MASK) << SHIFT);
+
+    typedef detail::CrcKernel<Policy, value_type, REG_WIDTH, Reflected, POLY> Kernel;
+
+    /**
+     * Convert between the bit order of the result and normal form (which is
+     * its own inverse).
+     */
+    static uint64_t toNormal(uint64_t v) {
+        return Reflected ? detail::reflect(v, Width) : v;
+    }
+
+    value_type _reg;
+};
+
+template<size_t Width, uint64_t Poly, uint64_t Init, bool Reflected, uint64_t XorOut,
+    typename Policy>
+constexpr size_t Crc<Width, Poly, Init, Reflected, XorOut, Policy>::REG_WIDTH;
+
+template<size_t Width, uint64_t Poly, uint64_t Init, bool Reflected, uint64_t XorOut,
+    typename Policy>
+constexpr size_t Crc<Width, Poly, Init, Reflected, XorOut, Policy>::SHIFT;
+
+template<size_t Width, uint64_t Poly, uint64_t Init, bool Reflected, uint64_t XorOut,
+    typename Policy>
+constexpr uint64_t Crc<Width, Poly, Init, Reflected, XorOut, Policy>::MASK;
+
+template<size_t Width, uint64_t Poly, uint64_t Init, bool Reflected, uint64_t XorOut,
+    typename Policy>
+constexpr uint64_t Crc<Width, Poly, Init, Reflected, XorOut, Policy>::POLY;
+
+template<size_t Width, uint64_t Poly, uint64_t Init, bool Reflected, uint64_t XorOut,
+    typename Policy>
+constexpr typename Crc<Width, Poly, Init, Reflected, XorOut, Policy>::value_type
+    Crc<Width, Poly, Init, Reflected, XorOut, Policy>::INIT;
+
+/**
+ * CRC-8/SMBUS.
+ */
+typedef Crc<8, 0x07, 0x00, false, 0x00> Crc8;
+
+/**
+ * CRC-16/CCITT-FALSE, as used by many radio and serial protocols.
+ */
+typedef Crc<16, 0x1021, 0xffff, false, 0x0000> Crc16Ccitt;
+
+/**
+ * CRC-16/MODBUS.
+ */
+typedef Crc<16, 0x8005, 0xffff, true, 0x0000> Crc16Modbus;
+
+/**
+ * CRC-32, as used by Ethernet, zlib and PNG.
+ */
+typedef Crc<32, 0x04c11db7, 0xffffffff, true, 0xffffffff> Crc32;
+
+} // namespace safearray
+
+#endif
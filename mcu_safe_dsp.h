@@ -0,0 +1,534 @@
+#ifndef __MCU_SAFE_DSP_H__
+#define __MCU_SAFE_DSP_H__
+
+/**
+ * \file
+ *
+ * Fixed-point signal processing on Q15 (\c int16_t) and Q31 (\c int32_t)
+ * samples: dot products, FIR and biquad filters, and moving averages.
+ * Products are accumulated in 64 bits, and results are rounded to the
+ * nearest and saturated.
+ */
+
+#include "mcu_safe_array.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+namespace safearray {
+
+/**
+ * \brief The coefficients of one second-order section of a
+ * \c BiquadCascade, which computes
+ * <tt>y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]</tt>.
+ *
+ * \tparam T \c int16_t or \c int32_t.
+ */
+template<typename T>
+struct BiquadCoeffs {
+    T b0;
+    T b1;
+    T b2;
+    T a1;
+    T a2;
+};
+
+namespace detail {
+
+/**
+ * The arithmetic for a fixed-point sample type.  \c mul gives a product
+ * with \c PRODUCT_FRACTION_BITS fractional bits, and there's room to add
+ * at least \c 2^14 of them up in an \c int64_t.
+ */
+template<typename T>
+struct FixedPoint;
+
+template<>
+struct FixedPoint<int16_t> {
+    static const unsigned FRACTION_BITS = 15;
+    static const unsigned PRODUCT_FRACTION_BITS = 30;
+    static const int16_t MIN = -0x7fff - 1;
+    static const int16_t MAX = 0x7fff;
+
+    static int32_t mul(int16_t a, int16_t b) {
+        return (int32_t) a * b;
+    }
+};
+
+template<>
+struct FixedPoint<int32_t> {
+    static const unsigned FRACTION_BITS = 31;
+    static const unsigned PRODUCT_FRACTION_BITS = 48;
+    static const int32_t MIN = -0x7fffffff - 1;
+    static const int32_t MAX = 0x7fffffff;
+
+    static int64_t mul(int32_t a, int32_t b) {
+        return ((int64_t) a * b) >> 14;
+    }
+};
+
+/**
+ * Shift a sum of products right, rounding to the nearest, and saturate it.
+ */
+template<typename T>
+T fromProducts(int64_t acc, unsigned shift) {
+    const int64_t lo = FixedPoint<T>::MIN;
+    const int64_t hi = FixedPoint<T>::MAX;
+    acc = (acc + ((int64_t) 1 << (shift - 1))) >> shift;
+    return (T) (acc < lo ? lo : acc > hi ? hi : acc);
+}
+
+/**
+ * Dot products up to this long are unrolled completely at compile-time,
+ * unless they're long enough for \c dotLoop's vector instructions.
+ */
+const size_t DSP_UNROLL_MAX_SIZE = 16;
+
+#if defined(__SSE2__)
+/**
+ * The number of Q15 products that \c dotLoop computes at once.
+ */
+const size_t DSP_VECTOR_DOT_SIZE = 8;
+#elif defined(__ARM_FEATURE_SIMD32)
+const size_t DSP_VECTOR_DOT_SIZE = 2;
+#else
+const size_t DSP_VECTOR_DOT_SIZE = (size_t) -1;
+#endif
+
+/**
+ * The sum of the products of \c a[I] to \c a[N-1] and \c b[I] to \c b[N-1],
+ * unrolled.
+ */
+template<typename T, size_t N, size_t I = 0, bool More = (I < N)>
+struct UnrolledDot {
+    static int64_t apply(const T *a, const T *b) {
+        return FixedPoint<T>::mul(a[I], b[I]) + UnrolledDot<T, N, I + 1>::apply(a, b);
+    }
+};
+
+template<typename T, size_t N, size_t I>
+struct UnrolledDot<T, N, I, false> {
+    static int64_t apply(const T *, const T *) {
+        return 0;
+    }
+};
+
+template<typename T>
+int64_t dotLoop(const T *a, const T *b, size_t n) {
+    int64_t acc = 0;
+    for (size_t i = 0; i < n; ++i) {
+        acc += FixedPoint<T>::mul(a[i], b[i]);
+    }
+    return acc;
+}
+
+inline int64_t dotLoop(const int16_t *a, const int16_t *b, size_t n) {
+    int64_t acc = 0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    // pmaddwd adds pairs of products, which only overflows for
+    // 2 * (-32768 * -32768).  Every pair sum minus one fits, so that's
+    // what's widened and accumulated; the ones are added back at the end.
+    const __m128i ones = _mm_set1_epi32(1);
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    for (; n - i >= DSP_VECTOR_DOT_SIZE; i += DSP_VECTOR_DOT_SIZE) {
+        __m128i x = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *) (b + i));
+        __m128i p = _mm_sub_epi32(_mm_madd_epi16(x, y), ones);
+        __m128i sign = _mm_srai_epi32(p, 31);
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(p, sign));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(p, sign));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128((__m128i *) lanes, _mm_add_epi64(acc0, acc1));
+    acc = lanes[0] + lanes[1] + (int64_t) (i / 2);
+#elif defined(__ARM_FEATURE_SIMD32)
+    // Two multiplies and a 64-bit accumulate per instruction.
+    for (; n - i >= DSP_VECTOR_DOT_SIZE; i += DSP_VECTOR_DOT_SIZE) {
+        int32_t x, y;
+        memcpy(&x, a + i, sizeof(x));
+        memcpy(&y, b + i, sizeof(y));
+        acc = __smlald(x, y, acc);
+    }
+#endif
+    return acc + dotLoop<int16_t>(a + i, b + i, n - i);
+}
+
+template<typename T, size_t N,
+         bool Unrolled = (N <= DSP_UNROLL_MAX_SIZE) && (sizeof(T) != 2 || N < DSP_VECTOR_DOT_SIZE)>
+struct Dot {
+    static int64_t apply(const T *a, const T *b) {
+        return UnrolledDot<T, N>::apply(a, b);
+    }
+};
+
+template<typename T, size_t N>
+struct Dot<T, N, false> {
+    static int64_t apply(const T *a, const T *b) {
+        return dotLoop(a, b, N);
+    }
+};
+
+/**
+ * Divide, rounding to the nearest (and halves away from zero).
+ */
+template<typename I>
+I roundingDivide(I sum, I n) {
+    return sum >= 0 ? (sum + n / 2) / n : -((n / 2 - sum) / n);
+}
+
+/**
+ * The type that sums of \c N samples are kept in.
+ */
+template<typename T>
+struct SampleSum {
+    typedef int64_t type;
+};
+
+template<>
+struct SampleSum<int16_t> {
+    typedef int32_t type;
+};
+
+} // namespace detail
+
+/**
+ * \brief Compute the dot product of two Q15 or Q31 vectors.
+ *
+ * \tparam T \c int16_t (Q15) or \c int32_t (Q31).
+ *
+ * Q15 products are summed exactly; Q31 ones with 48 fractional bits.
+ * Q15 vectors use SSE2 or the Arm DSP extension's dual multiply-accumulate,
+ * if available.  Otherwise, vectors of up to 16 elements are unrolled at
+ * compile-time.
+ *
+ * \return The sum, rounded to the nearest and saturated.
+ */
+template<typename T, size_t L>
+T dot(CSlice<T, L> a, CSlice<T, L> b) {
+    return detail::fromProducts<T>(detail::Dot<T, L>::apply(a.cdata(), b.cdata()),
+        detail::FixedPoint<T>::PRODUCT_FRACTION_BITS - detail::FixedPoint<T>::FRACTION_BITS);
+}
+
+/**
+ * \copydoc dot(CSlice<T, L>, CSlice<T, L>)
+ */
+template<typename T, size_t L>
+T dot(const Array<T, L>& a, const Array<T, L>& b) {
+    return dot(a.cslice(), b.cslice());
+}
+
+/**
+ * \brief A finite impulse response filter with Q15 or Q31 coefficients.
+ *
+ * \tparam T \c int16_t (Q15) or \c int32_t (Q31).
+ * \tparam Taps The number of coefficients.
+ *
+ * The delay line is stored twice over, so that the last \c Taps samples
+ * are always contiguous, and each output is one dot product (see \c dot)
+ * whose length is known at compile-time.
+ *
+ * \code
+ * constexpr safearray::Array<int16_t, 5> LOWPASS = {{2621, 7864, 11141, 7864, 2621}};
+ * static safearray::FirFilter<int16_t, 5> fir(LOWPASS);
+ *
+ * fir.process(block.cslice(), block.slice());
+ * \endcode
+ */
+template<typename T, size_t Taps>
+class FirFilter
+{
+public:
+    static_assert(Taps > 0, "Bad number of taps");
+
+    /**
+     * \brief Make a filter whose delay line is all zeros.
+     *
+     * \param coeffs The coefficients, \c coeffs[k] being the weight of the
+     * sample \c k samples ago.  They aren't copied.
+     */
+    explicit FirFilter(CSlice<T, Taps> coeffs) : _coeffs(coeffs), _delay{}, _pos(0) {}
+
+    /**
+     * \copydoc FirFilter(CSlice<T, Taps>)
+     */
+    explicit FirFilter(const Array<T, Taps>& coeffs) : FirFilter(coeffs.cslice()) {}
+
+    /**
+     * \brief This constructor is deleted to prevent accidental copies.
+     */
+    FirFilter(const FirFilter& other) = delete;
+
+    /**
+     * \brief This method is deleted to prevent accidental copies.
+     */
+    FirFilter& operator=(const FirFilter& other) = delete;
+
+    /**
+     * \brief Filter one sample.
+     *
+     * \return The output, rounded to the nearest and saturated.
+     */
+    T push(T sample) {
+        this->_pos = this->_pos == 0 ? Taps - 1 : this->_pos - 1;
+        T *delay = this->_delay.data();
+        delay[this->_pos] = sample;
+        delay[this->_pos + Taps] = sample;
+        return detail::fromProducts<T>(
+            detail::Dot<T, Taps>::apply(this->_coeffs.cdata(), delay + this->_pos),
+            detail::FixedPoint<T>::PRODUCT_FRACTION_BITS - detail::FixedPoint<T>::FRACTION_BITS);
+    }
+
+    /**
+     * \brief Filter a block of samples.
+     *
+     * \param in The samples.
+     * \param out Where to put the outputs.  It may be the same as \c in.
+     */
+    template<size_t L>
+    void process(CSlice<T, L> in, Slice<T, L> out) {
+        for (size_t i = 0; i < L; ++i) {
+            out.data()[i] = this->push(in.cdata()[i]);
+        }
+    }
+
+    /**
+     * \brief Set the delay line to all zeros.
+     */
+    void reset() {
+        memset(this->_delay.data(), 0, sizeof(this->_delay));
+    }
+
+private:
+    CSlice<T, Taps> _coeffs;
+    Array<T, 2 * Taps> _delay;
+    size_t _pos;
+};
+
+/**
+ * \brief A cascade of second-order (biquad) IIR sections with Q15 or Q31
+ * coefficients, in direct form I.
+ *
+ * \tparam T \c int16_t (Q15) or \c int32_t (Q31).
+ * \tparam Stages The number of sections.
+ * \tparam Shift The coefficients are scaled down by \c 2^Shift, so that
+ * ones as big as \c 2 (as \c a1 often is) can be represented with the
+ * default of \c 1.  It's statically checked to be less than \c 15 for Q15,
+ * or \c 17 for Q31.
+ *
+ * Each section's output is rounded and saturated before it's fed to the
+ * next one.
+ */
+template<typename T, size_t Stages, unsigned Shift = 1>
+class BiquadCascade
+{
+public:
+    static_assert(Stages > 0, "Bad number of stages");
+    static_assert(Shift < detail::FixedPoint<T>::PRODUCT_FRACTION_BITS
+                  - detail::FixedPoint<T>::FRACTION_BITS, "Bad shift");
+
+    /**
+     * \brief Make a cascade whose state is all zeros.
+     *
+     * \param coeffs The coefficients of each section, scaled down by
+     * \c 2^Shift.  They aren't copied.
+     */
+    explicit BiquadCascade(CSlice<BiquadCoeffs<T>, Stages> coeffs) : _coeffs(coeffs), _state{} {}
+
+    /**
+     * \copydoc BiquadCascade(CSlice<BiquadCoeffs<T>, Stages>)
+     */
+    explicit BiquadCascade(const Array<BiquadCoeffs<T>, Stages>& coeffs)
+        : BiquadCascade(coeffs.cslice()) {}
+
+    /**
+     * \brief This constructor is deleted to prevent accidental copies.
+     */
+    BiquadCascade(const BiquadCascade& other) = delete;
+
+    /**
+     * \brief This method is deleted to prevent accidental copies.
+     */
+    BiquadCascade& operator=(const BiquadCascade& other) = delete;
+
+    /**
+     * \brief Filter one sample.
+     *
+     * \return The output of the last section.
+     */
+    T push(T sample) {
+        typedef detail::FixedPoint<T> F;
+        const unsigned shift = F::PRODUCT_FRACTION_BITS - F::FRACTION_BITS - Shift;
+        const BiquadCoeffs<T> *c = this->_coeffs.cdata();
+        State *s = this->_state.data();
+        for (size_t i = 0; i < Stages; ++i) {
+            int64_t acc = (int64_t) F::mul(c[i].b0, sample) + F::mul(c[i].b1, s[i].x1)
+                + F::mul(c[i].b2, s[i].x2) - F::mul(c[i].a1, s[i].y1) - F::mul(c[i].a2, s[i].y2);
+            T y = detail::fromProducts<T>(acc, shift);
+            s[i].x2 = s[i].x1;
+            s[i].x1 = sample;
+            s[i].y2 = s[i].y1;
+            s[i].y1 = y;
+            sample = y;
+        }
+        return sample;
+    }
+
+    /**
+     * \brief Filter a block of samples.
+     *
+     * \param in The samples.
+     * \param out Where to put the outputs.  It may be the same as \c in.
+     */
+    template<size_t L>
+    void process(CSlice<T, L> in, Slice<T, L> out) {
+        for (size_t i = 0; i < L; ++i) {
+            out.data()[i] = this->push(in.cdata()[i]);
+        }
+    }
+
+    /**
+     * \brief Set the state of every section to all zeros.
+     */
+    void reset() {
+        memset(this->_state.data(), 0, sizeof(this->_state));
+    }
+
+private:
+    struct State {
+        T x1;
+        T x2;
+        T y1;
+        T y2;
+    };
+
+    CSlice<BiquadCoeffs<T>, Stages> _coeffs;
+    Array<State, Stages> _state;
+};
+
+/**
+ * \brief The average of the last \c N samples, updated in constant time.
+ *
+ * \tparam T \c int16_t or \c int32_t.
+ * \tparam N The number of samples in the window.
+ *
+ * \code
+ * static safearray::MovingAverage<int16_t, 16> average;
+ *
+ * int16_t smoothed = average.push(readSensor());
+ * \endcode
+ */
+template<typename T, size_t N>
+class MovingAverage
+{
+public:
+    static_assert(N > 0, "Bad window size");
+
+    /**
+     * \brief Make an empty window.
+     */
+    MovingAverage() : _ring{}, _sum(0), _head(0), _size(0) {}
+
+    /**
+     * \brief This constructor is deleted to prevent accidental copies.
+     */
+    MovingAverage(const MovingAverage& other) = delete;
+
+    /**
+     * \brief This method is deleted to prevent accidental copies.
+     */
+    MovingAverage& operator=(const MovingAverage& other) = delete;
+
+    /**
+     * \brief Add a sample, dropping the oldest one if the window is full.
+     *
+     * \return The average of the window (of all the samples so far, until
+     * there are \c N of them), rounded to the nearest.
+     */
+    T push(T sample) {
+        T *ring = this->_ring.data();
+        if (this->_size == N) {
+            this->_sum -= ring[this->_head];
+        } else {
+            ++this->_size;
+        }
+        this->_sum += sample;
+        ring[this->_head] = sample;
+        this->_head = this->_head + 1 == N ? 0 : this->_head + 1;
+        return this->average();
+    }
+
+    /**
+     * \brief Get the average of the window.
+     *
+     * \return The average, rounded to the nearest, or \c 0 if there are no
+     * samples.
+     */
+    T average() const {
+        typedef typename detail::SampleSum<T>::type S;
+        if (this->_size == N) {
+            return (T) detail::roundingDivide(this->_sum, (S) N);
+        }
+        return this->_size > 0 ? (T) detail::roundingDivide(this->_sum, (S) this->_size) : 0;
+    }
+
+    /**
+     * \brief Drop all the samples.
+     */
+    void clear() {
+        this->_sum = 0;
+        this->_head = 0;
+        this->_size = 0;
+    }
+
+private:
+    Array<T, N> _ring;
+    typename detail::SampleSum<T>::type _sum;
+    size_t _head;
+    size_t _size;
+};
+
+/**
+ * \brief Compute the moving average of a block of samples.
+ *
+ * \tparam N The number of samples averaged for each output.  It's
+ * statically checked to be at least \c 1 and at most \c L.
+ * \tparam T \c int16_t or \c int32_t.
+ * \param in The samples.
+ * \param out Where to put the averages of \c in[0..N-1], \c in[1..N], and
+ * so on, rounded to the nearest.  Its length is statically checked to be
+ * \c L-N+1.
+ */
+template<size_t N, typename T, size_t L, size_t M>
+void movingAverage(CSlice<T, L> in, Slice<T, M> out) {
+    static_assert(N > 0 && N <= L, "Bad window size");
+    static_assert(M == L - N + 1, "Destination has the wrong size");
+    typedef typename detail::SampleSum<T>::type S;
+    const T *x = in.cdata();
+    T *y = out.data();
+    S sum = 0;
+    for (size_t i = 0; i < N; ++i) {
+        sum += x[i];
+    }
+    y[0] = (T) detail::roundingDivide(sum, (S) N);
+    for (size_t i = N; i < L; ++i) {
+        sum += x[i] - (S) x[i - N];
+        y[i - N + 1] = (T) detail::roundingDivide(sum, (S) N);
+    }
+}
+
+/**
+ * \copydoc movingAverage(CSlice<T, L>, Slice<T, M>)
+ */
+template<size_t N, typename T, size_t L, size_t M>
+void movingAverage(const Array<T, L>& in, Array<T, M>& out) {
+    movingAverage<N>(in.cslice(), out.slice());
+}
+
+} // namespace safearray
+
+#endif
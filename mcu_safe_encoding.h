@@ -0,0 +1,442 @@
+#ifndef __MCU_SAFE_ENCODING_H__
+#define __MCU_SAFE_ENCODING_H__
+
+/**
+ * \file
+ *
+ * Hex and Base64 (RFC 4648, with padding) encoding and decoding, with
+ * output sizes checked at compile-time.
+ */
+
+#include "mcu_safe_array.h"
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace safearray {
+
+/**
+ * \brief The number of characters in the hex encoding of \c L bytes.
+ */
+template<size_t L>
+struct HexEncodedSize {
+    static constexpr size_t value = 2 * L;
+};
+
+template<size_t L>
+constexpr size_t HexEncodedSize<L>::value;
+
+/**
+ * \brief The number of characters in the Base64 encoding of \c L bytes,
+ * including padding.
+ */
+template<size_t L>
+struct Base64EncodedSize {
+    static constexpr size_t value = 4 * ((L + 2) / 3);
+};
+
+template<size_t L>
+constexpr size_t Base64EncodedSize<L>::value;
+
+namespace detail {
+
+/**
+ * The lookup tables, which are in flash on AVR.
+ */
+template<typename Dummy = void>
+struct EncodingTables {
+    static const char hex[16];
+    static const char base64[64];
+
+    /**
+     * The value of each ASCII character in Base64, or \c 0xff.
+     */
+    static const unsigned char base64Values[128];
+};
+
+template<typename Dummy>
+const char EncodingTables<Dummy>::hex[16] SAFEARRAY_PROGMEM = {
+    '0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f',
+};
+
+template<typename Dummy>
+const char EncodingTables<Dummy>::base64[64] SAFEARRAY_PROGMEM = {
+    'A','B','C','D','E','F','G','H','I','J','K','L','M','N','O','P',
+    'Q','R','S','T','U','V','W','X','Y','Z','a','b','c','d','e','f',
+    'g','h','i','j','k','l','m','n','o','p','q','r','s','t','u','v',
+    'w','x','y','z','0','1','2','3','4','5','6','7','8','9','+','/',
+};
+
+template<typename Dummy>
+const unsigned char EncodingTables<Dummy>::base64Values[128] SAFEARRAY_PROGMEM = {
+    0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+    0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,
+    0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,  62,0xff,0xff,0xff,  63,
+      52,  53,  54,  55,  56,  57,  58,  59,  60,  61,0xff,0xff,0xff,0xff,0xff,0xff,
+    0xff,   0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,
+      15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,0xff,0xff,0xff,0xff,0xff,
+    0xff,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,
+      41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51,0xff,0xff,0xff,0xff,0xff,
+};
+
+inline void hexEncode(const unsigned char *src, size_t n, char *dest) {
+    const char *digits = EncodingTables<>::hex;
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i letters = _mm_set1_epi8('a' - '0' - 10);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+        __m128i lo = _mm_and_si128(v, nibble);
+        hi = _mm_add_epi8(_mm_add_epi8(hi, zero), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), letters));
+        lo = _mm_add_epi8(_mm_add_epi8(lo, zero), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), letters));
+        _mm_storeu_si128((__m128i *) (dest + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *) (dest + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+#endif
+    // With dest[2 * i], GCC can't tell that this loop doesn't run when the
+    // one above has done all the bytes, and warns that 2 * i overflows.
+    char *d = dest + 2 * i;
+    for (const unsigned char *s = src + i; s < src + n; ++s) {
+        *d++ = (char) SAFEARRAY_READ_PROGMEM_BYTE(digits + (*s >> 4));
+        *d++ = (char) SAFEARRAY_READ_PROGMEM_BYTE(digits + (*s & 0xf));
+    }
+}
+
+/**
+ * The value of a hex digit (in either case), or \c 0xff.
+ */
+inline unsigned hexValue(char c) {
+    unsigned d = (unsigned) (unsigned char) c - '0';
+    if (d < 10) {
+        return d;
+    }
+    unsigned l = ((unsigned) (unsigned char) c | 0x20) - 'a';
+    return l < 6 ? l + 10 : 0xff;
+}
+
+/**
+ * Decode \c 2n hex digits into \c n bytes.
+ */
+inline bool hexDecode(const char *src, size_t n, unsigned char *dest) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i five = _mm_set1_epi8(5);
+    const __m128i low = _mm_set1_epi16(0x00ff);
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *) (src + 2 * i));
+        __m128i b = _mm_loadu_si128((const __m128i *) (src + 2 * i + 16));
+        __m128i vals[2];
+        int valid = 0xffff;
+        for (int k = 0; k < 2; ++k) {
+            __m128i c = k == 0 ? a : b;
+            __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+            __m128i l = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+            // x <= n, unsigned, iff min(x, n) == x
+            __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(d, nine), d);
+            __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(l, five), l);
+            valid &= _mm_movemask_epi8(_mm_or_si128(isDigit, isLetter));
+            vals[k] = _mm_or_si128(_mm_and_si128(isDigit, d),
+                                   _mm_andnot_si128(isDigit, _mm_add_epi8(l, _mm_set1_epi8(10))));
+        }
+        if (valid != 0xffff) {
+            return false;
+        }
+        // Each 16-bit lane holds a byte's high digit, then its low digit.
+        __m128i x = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(vals[0], low), 4),
+                                 _mm_srli_epi16(vals[0], 8));
+        __m128i y = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(vals[1], low), 4),
+                                 _mm_srli_epi16(vals[1], 8));
+        _mm_storeu_si128((__m128i *) (dest + i), _mm_packus_epi16(x, y));
+    }
+#endif
+    for (; i < n; ++i) {
+        unsigned hi = hexValue(src[2 * i]);
+        unsigned lo = hexValue(src[2 * i + 1]);
+        if ((hi | lo) == 0xff) {
+            return false;
+        }
+        dest[i] = (unsigned char) (hi << 4 | lo);
+    }
+    return true;
+}
+
+inline void base64Encode(const unsigned char *src, size_t n, char *dest) {
+    const char *alphabet = EncodingTables<>::base64;
+    size_t i = 0;
+    size_t o = 0;
+#if defined(__SSSE3__)
+    // Reshuffle 12 bytes into 16 6-bit indices, then map those to ASCII by
+    // range.  See Wojciech Mula, "Base64 encoding with SIMD instructions".
+    const __m128i shuffle = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    for (; i + 16 <= n; i += 12, o += 16) {
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (src + i)), shuffle);
+        __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)),
+                                     _mm_set1_epi32(0x04000040));
+        __m128i t1 = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003f03f0)),
+                                     _mm_set1_epi32(0x01000010));
+        __m128i indices = _mm_or_si128(t0, t1);
+        __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices),
+                                                  _mm_set1_epi8(13)));
+        __m128i ascii = _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range));
+        _mm_storeu_si128((__m128i *) (dest + o), ascii);
+    }
+#endif
+    for (; i + 3 <= n; i += 3, o += 4) {
+        uint32_t v = (uint32_t) src[i] << 16 | (uint32_t) src[i + 1] << 8 | src[i + 2];
+        dest[o] = (char) SAFEARRAY_READ_PROGMEM_BYTE(alphabet + (v >> 18));
+        dest[o + 1] = (char) SAFEARRAY_READ_PROGMEM_BYTE(alphabet + (v >> 12 & 0x3f));
+        dest[o + 2] = (char) SAFEARRAY_READ_PROGMEM_BYTE(alphabet + (v >> 6 & 0x3f));
+        dest[o + 3] = (char) SAFEARRAY_READ_PROGMEM_BYTE(alphabet + (v & 0x3f));
+    }
+    if (i < n) {
+        uint32_t v = (uint32_t) src[i] << 16 | (i + 1 < n ? (uint32_t) src[i + 1] << 8 : 0);
+        dest[o] = (char) SAFEARRAY_READ_PROGMEM_BYTE(alphabet + (v >> 18));
+        dest[o + 1] = (char) SAFEARRAY_READ_PROGMEM_BYTE(alphabet + (v >> 12 & 0x3f));
+        dest[o + 2] = i + 1 < n ? (char) SAFEARRAY_READ_PROGMEM_BYTE(alphabet + (v >> 6 & 0x3f))
+                                : '=';
+        dest[o + 3] = '=';
+    }
+}
+
+inline unsigned base64Value(char c) {
+    unsigned char u = (unsigned char) c;
+    return u < 128 ? SAFEARRAY_READ_PROGMEM_BYTE(EncodingTables<>::base64Values + u) : 0xff;
+}
+
+/**
+ * Decode \c Base64EncodedSize<n> characters into \c n bytes.  The padding
+ * must match \c n.
+ */
+inline bool base64Decode(const char *src, size_t n, unsigned char *dest) {
+    size_t i = 0;
+    size_t o = 0;
+#if defined(__SSSE3__)
+    // Validate and translate by nibble lookups, then pack 16 6-bit values
+    // into 12 bytes.  See Wojciech Mula, "Base64 decoding with SIMD
+    // instructions".
+    const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                        0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                          0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2f = _mm_set1_epi8(0x2f);
+    const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    // Stop before the last group, which may be padded.
+    for (; o + 12 < n; i += 16, o += 12) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(v, 4), mask2f);
+        __m128i lo = _mm_shuffle_epi8(lutLo, _mm_and_si128(v, mask2f));
+        __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()))
+                != 0xffff) {
+            return false;
+        }
+        __m128i roll = _mm_shuffle_epi8(lutRoll,
+                                        _mm_add_epi8(_mm_cmpeq_epi8(v, mask2f), hiNibbles));
+        v = _mm_add_epi8(v, roll);
+        v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+        v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+        v = _mm_shuffle_epi8(v, pack);
+        // Only 12 of the 16 bytes are valid, and there may be no room for
+        // the other 4.
+        unsigned char tmp[16];
+        _mm_storeu_si128((__m128i *) tmp, v);
+        memcpy(dest + o, tmp, 12);
+    }
+#endif
+    for (; o + 3 <= n; i += 4, o += 3) {
+        unsigned a = base64Value(src[i]);
+        unsigned b = base64Value(src[i + 1]);
+        unsigned c = base64Value(src[i + 2]);
+        unsigned d = base64Value(src[i + 3]);
+        if ((a | b | c | d) == 0xff) {
+            return false;
+        }
+        uint32_t v = (uint32_t) a << 18 | (uint32_t) b << 12 | c << 6 | d;
+        dest[o] = (unsigned char) (v >> 16);
+        dest[o + 1] = (unsigned char) (v >> 8);
+        dest[o + 2] = (unsigned char) v;
+    }
+    if (o < n) {
+        bool two = o + 2 == n;
+        unsigned a = base64Value(src[i]);
+        unsigned b = base64Value(src[i + 1]);
+        unsigned c = two ? base64Value(src[i + 2]) : (src[i + 2] == '=' ? 0 : 0xff);
+        if ((a | b | c) == 0xff || src[i + 3] != '=') {
+            return false;
+        }
+        dest[o] = (unsigned char) (a << 2 | b >> 4);
+        if (two) {
+            dest[o + 1] = (unsigned char) (b << 4 | c >> 2);
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+
+/**
+ * \brief Encode bytes as lowercase hex.
+ *
+ * \param src The bytes to encode.
+ * \param dest Where to put the digits.  Its length is statically checked to
+ * be exactly \c HexEncodedSize<L>.
+ */
+template<size_t L, size_t M>
+void hexEncode(CByteSlice<L> src, Slice<char, M> dest) {
+    static_assert(M == HexEncodedSize<L>::value, "Destination has the wrong size");
+    detail::hexEncode(src.cdata(), L, dest.data());
+}
+
+/**
+ * \copydoc hexEncode(CByteSlice<L>, Slice<char, M>)
+ */
+template<size_t L, size_t M>
+void hexEncode(CByteSlice<L> src, Array<char, M>& dest) {
+    hexEncode(src, dest.slice());
+}
+
+/**
+ * \brief Decode hex digits (in either case) into bytes.
+ *
+ * \param src The digits.  Its length is statically checked to be exactly
+ * \c HexEncodedSize<L>.
+ * \param dest Where to put the bytes.
+ *
+ * \return \c false iff \c src has a character that isn't a hex digit, in
+ * which case \c dest may be partly written.
+ */
+template<size_t M, size_t L>
+bool hexDecode(CSlice<char, M> src, ByteSlice<L> dest) {
+    static_assert(M == HexEncodedSize<L>::value, "Source has the wrong size");
+    return detail::hexDecode(src.cdata(), L, dest.data());
+}
+
+/**
+ * \copydoc hexDecode(CSlice<char, M>, ByteSlice<L>)
+ */
+template<size_t M, size_t L>
+bool hexDecode(CSlice<char, M> src, ByteArray<L>& dest) {
+    return hexDecode(src, dest.slice());
+}
+
+/**
+ * \brief Decode hex digits whose number is only known at runtime.
+ *
+ * \param size Set to the number of bytes decoded.
+ *
+ * \return \c false iff \c src has an odd length or a character that isn't a
+ * hex digit, or \c dest is too short.
+ */
+template<size_t L>
+bool hexDecode(CArrayPtr<char> src, ByteSlice<L> dest, size_t& size) {
+    if (src.size() % 2 != 0 || src.size() / 2 > L
+            || !detail::hexDecode(src.data(), src.size() / 2, dest.data())) {
+        return false;
+    }
+    size = src.size() / 2;
+    return true;
+}
+
+/**
+ * \copydoc hexDecode(CArrayPtr<char>, ByteSlice<L>, size_t&)
+ */
+template<size_t L>
+bool hexDecode(CArrayPtr<char> src, ByteArray<L>& dest, size_t& size) {
+    return hexDecode(src, dest.slice(), size);
+}
+
+/**
+ * \brief Encode bytes as Base64, with padding.
+ *
+ * \param src The bytes to encode.
+ * \param dest Where to put the characters.  Its length is statically checked
+ * to be exactly \c Base64EncodedSize<L>.
+ */
+template<size_t L, size_t M>
+void base64Encode(CByteSlice<L> src, Slice<char, M> dest) {
+    static_assert(M == Base64EncodedSize<L>::value, "Destination has the wrong size");
+    detail::base64Encode(src.cdata(), L, dest.data());
+}
+
+/**
+ * \copydoc base64Encode(CByteSlice<L>, Slice<char, M>)
+ */
+template<size_t L, size_t M>
+void base64Encode(CByteSlice<L> src, Array<char, M>& dest) {
+    base64Encode(src, dest.slice());
+}
+
+/**
+ * \brief Decode Base64 into exactly \c L bytes.
+ *
+ * \param src The characters, including padding.  Its length is statically
+ * checked to be exactly \c Base64EncodedSize<L>.
+ * \param dest Where to put the bytes.
+ *
+ * \return \c false iff \c src has a character outside the Base64 alphabet,
+ * or its padding doesn't match \c L, in which case \c dest may be partly
+ * written.
+ */
+template<size_t M, size_t L>
+bool base64Decode(CSlice<char, M> src, ByteSlice<L> dest) {
+    static_assert(M == Base64EncodedSize<L>::value, "Source has the wrong size");
+    return detail::base64Decode(src.cdata(), L, dest.data());
+}
+
+/**
+ * \copydoc base64Decode(CSlice<char, M>, ByteSlice<L>)
+ */
+template<size_t M, size_t L>
+bool base64Decode(CSlice<char, M> src, ByteArray<L>& dest) {
+    return base64Decode(src, dest.slice());
+}
+
+/**
+ * \brief Decode Base64 whose length is only known at runtime.
+ *
+ * \param size Set to the number of bytes decoded.
+ *
+ * \return \c false iff \c src isn't padded Base64, or \c dest is too short.
+ */
+template<size_t L>
+bool base64Decode(CArrayPtr<char> src, ByteSlice<L> dest, size_t& size) {
+    size_t n = src.size();
+    if (n % 4 != 0) {
+        return false;
+    }
+    size_t decoded = n / 4 * 3;
+    if (n > 0 && src.data()[n - 1] == '=') {
+        decoded -= src.data()[n - 2] == '=' ? 2 : 1;
+    }
+    if (decoded > L || !detail::base64Decode(src.data(), decoded, dest.data())) {
+        return false;
+    }
+    size = decoded;
+    return true;
+}
+
+/**
+ * \copydoc base64Decode(CArrayPtr<char>, ByteSlice<L>, size_t&)
+ */
+template<size_t L>
+bool base64Decode(CArrayPtr<char> src, ByteArray<L>& dest, size_t& size) {
+    return base64Decode(src, dest.slice(), size);
+}
+
+} // namespace safearray
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef __MCU_SAFE_FILTER_H__
+#define __MCU_SAFE_FILTER_H__
+
+/**
+ * \file
+ *
+ * Median and percentile filters over a sliding window of samples.
+ */
+
+#include "mcu_safe_sort.h"
+
+namespace safearray {
+
+namespace detail {
+
+/**
+ * The index of the last of the \c n (sorted) elements that \c v shouldn't
+ * come before, or \c 0 if there isn't one.  The number of steps depends
+ * only on \c n, and each one is a select, so there are no branches to
+ * mispredict.
+ */
+template<typename T>
+size_t lastNotAfter(const T *a, size_t n, T v) {
+    const T *base = a;
+    while (n > 1) {
+        size_t half = n / 2;
+        base = v < base[half] ? base : base + half;
+        n -= half;
+    }
+    return base - a;
+}
+
+/**
+ * The index of the first of the \c n (sorted) elements that \c v should
+ * come before.
+ */
+template<typename T>
+size_t upperBound(const T *a, size_t n, T v) {
+    if (n == 0) {
+        return 0;
+    }
+    size_t i = lastNotAfter(a, n, v);
+    return i + !(v < a[i]);
+}
+
+} // namespace detail
+
+/**
+ * \brief A median (or percentile) filter over the last \c N samples.
+ *
+ * \tparam T The type of sample, which must be trivially copyable and
+ * ordered by \c operator<.
+ * \tparam N The number of samples in the window.
+ *
+ * Besides the samples in the order they arrived, the filter keeps them
+ * sorted.  A new sample replaces the oldest one in the sorted copy by two
+ * branch-free binary searches and one \c memmove of the elements between
+ * them, so each sample takes \c O(log \c N) comparisons and nothing is
+ * re-sorted.  (For windows of a dozen or so samples, \c median() of a copy
+ * of the window can be as fast, since the sorting network has no
+ * branches.)
+ *
+ * \code
+ * static safearray::MedianFilter<int16_t, 7> filter;
+ *
+ * int16_t denoised = filter.push(readSensor());
+ * \endcode
+ */
+template<typename T, size_t N>
+class MedianFilter
+{
+public:
+    static_assert(N > 0, "Bad window size");
+
+    /**
+     * \brief Make an empty filter.
+     */
+    MedianFilter() : _ring{}, _sorted{}, _head(0), _size(0) {}
+
+    /**
+     * \brief This constructor is deleted to prevent accidental copies.
+     */
+    MedianFilter(const MedianFilter& other) = delete;
+
+    /**
+     * \brief This method is deleted to prevent accidental copies.
+     */
+    MedianFilter& operator=(const MedianFilter& other) = delete;
+
+    /**
+     * \brief Add a sample, dropping the oldest one if the window is full.
+     *
+     * \return The median of the window, including the new sample.
+     */
+    T push(T sample) {
+        T *sorted = this->_sorted.data();
+        if (this->_size < N) {
+            size_t i = detail::upperBound(sorted, this->_size, sample);
+            memmove(sorted + i + 1, sorted + i, (this->_size - i) * sizeof(T));
+            sorted[i] = sample;
+            ++this->_size;
+        } else {
+            // The oldest sample is certainly in the sorted copy, so this
+            // finds one that's equal to it.
+            size_t from = detail::lastNotAfter(sorted, N, this->_ring.data()[this->_head]);
+            size_t to = detail::upperBound(sorted, N, sample);
+            if (from < to) {
+                // Shift the ones between the old and new places down.
+                --to;
+                memmove(sorted + from, sorted + from + 1, (to - from) * sizeof(T));
+            } else {
+                memmove(sorted + to + 1, sorted + to, (from - to) * sizeof(T));
+            }
+            sorted[to] = sample;
+        }
+        this->_ring.data()[this->_head] = sample;
+        this->_head = this->_head + 1 == N ? 0 : this->_head + 1;
+        return this->median();
+    }
+
+    /**
+     * \brief Get the median of the window.  If it has an even number of
+     * samples, it's the lower of the two middle ones.
+     *
+     * \return The median, or \c T() if there are no samples.
+     */
+    T median() const {
+        return this->rank(this->_size > 0 ? (this->_size - 1) / 2 : 0);
+    }
+
+    /**
+     * \brief Get the \c P th percentile of the window, by the nearest rank.
+     *
+     * \tparam P The percentile.  It's statically checked to be at most
+     * \c 100.
+     *
+     * \return The percentile, or \c T() if there are no samples.
+     */
+    template<unsigned P>
+    T percentile() const {
+        static_assert(P <= 100, "Bad percentile");
+        return this->rank(this->_size > 0 ? ((this->_size - 1) * P + 50) / 100 : 0);
+    }
+
+    /**
+     * \brief Get the smallest sample but \c k.
+     *
+     * \return The sample, or \c T() if \c k \c >= \c size().
+     */
+    T rank(size_t k) const {
+        return k < this->_size ? this->_sorted.cdata()[k] : T();
+    }
+
+    /**
+     * \brief Make a pointer to the samples in the window, sorted.
+     */
+    CArrayPtr<T> sorted() const {
+        return CArrayPtr<T>(this->_sorted.cdata(), this->_size);
+    }
+
+    /**
+     * \brief Get the number of samples in the window.
+     */
+    size_t size() const {
+        return this->_size;
+    }
+
+    /**
+     * \return Whether the window has \c N samples.
+     */
+    bool full() const {
+        return this->_size == N;
+    }
+
+    /**
+     * \brief Drop all the samples.
+     */
+    void clear() {
+        this->_head = 0;
+        this->_size = 0;
+    }
+
+private:
+    Array<T, N> _ring;
+    Array<T, N> _sorted;
+    size_t _head;
+    size_t _size;
+};
+
+} // namespace safearray
+
+#endif
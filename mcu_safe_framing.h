@@ -0,0 +1,384 @@
+#ifndef __MCU_SAFE_FRAMING_H__
+#define __MCU_SAFE_FRAMING_H__
+
+/**
+ * \file
+ *
+ * COBS and SLIP framing for byte streams such as UARTs, with output buffers
+ * sized for the worst case at compile-time, and decoders that can be fed a
+ * byte at a time from an ISR.
+ */
+
+#include "mcu_safe_array.h"
+
+namespace safearray {
+
+/**
+ * \brief The maximum size of \c L bytes after COBS encoding, not counting
+ * the \c 0 delimiter.
+ */
+template<size_t L>
+struct CobsMaxEncodedSize {
+    static constexpr size_t value = L + L / 254 + 1;
+};
+
+template<size_t L>
+constexpr size_t CobsMaxEncodedSize<L>::value;
+
+/**
+ * \brief The maximum size of \c L bytes after SLIP encoding, including the
+ * \c END byte that terminates the frame.
+ */
+template<size_t L>
+struct SlipMaxEncodedSize {
+    static constexpr size_t value = 2 * L + 1;
+};
+
+template<size_t L>
+constexpr size_t SlipMaxEncodedSize<L>::value;
+
+namespace detail {
+
+const unsigned char SLIP_END = 0xc0;
+const unsigned char SLIP_ESC = 0xdb;
+const unsigned char SLIP_ESC_END = 0xdc;
+const unsigned char SLIP_ESC_ESC = 0xdd;
+
+inline size_t cobsEncode(const unsigned char *in, size_t size, unsigned char *out) {
+    unsigned char *start = out;
+    unsigned char *code = out++;
+    for (;;) {
+        // memchr scans a word (or a vector) at a time on most hosts.
+        size_t chunk = size < 254 ? size : 254;
+        const unsigned char *zero = (const unsigned char *) memchr(in, 0, chunk);
+        size_t n = zero != nullptr ? (size_t) (zero - in) : chunk;
+        *code = (unsigned char) (n + 1);
+        memcpy(out, in, n);
+        out += n;
+        in += n;
+        size -= n;
+        if (zero != nullptr) {
+            ++in;
+            --size;
+        } else if (size == 0) {
+            break;
+        }
+        code = out++;
+    }
+    return out - start;
+}
+
+inline bool cobsDecode(const unsigned char *in, size_t size, unsigned char *out,
+                       size_t capacity, size_t& decodedSize) {
+    size_t i = 0;
+    size_t o = 0;
+    while (i < size) {
+        unsigned char code = in[i++];
+        size_t n = code - 1u;
+        if (code == 0 || n > size - i || n > capacity - o
+                || memchr(in + i, 0, n) != nullptr) {
+            return false;
+        }
+        memcpy(out + o, in + i, n);
+        i += n;
+        o += n;
+        if (code != 0xff && i < size) {
+            if (o == capacity) {
+                return false;
+            }
+            out[o++] = 0;
+        }
+    }
+    decodedSize = o;
+    return true;
+}
+
+inline size_t slipEncode(const unsigned char *in, size_t size, unsigned char *out) {
+    unsigned char *start = out;
+    for (size_t i = 0; i < size; ++i) {
+        unsigned char b = in[i];
+        if (b == SLIP_END) {
+            *out++ = SLIP_ESC;
+            *out++ = SLIP_ESC_END;
+        } else if (b == SLIP_ESC) {
+            *out++ = SLIP_ESC;
+            *out++ = SLIP_ESC_ESC;
+        } else {
+            *out++ = b;
+        }
+    }
+    *out++ = SLIP_END;
+    return out - start;
+}
+
+} // namespace detail
+
+/**
+ * \brief COBS-encode bytes, so that the result contains no \c 0 bytes.
+ *
+ * The \c 0 that delimits frames isn't added.
+ *
+ * \param src The bytes to encode.
+ * \param dest Where to put the result.  Its length is statically checked
+ * against \c CobsMaxEncodedSize<L>.
+ *
+ * \return A pointer to the encoded bytes, at the beginning of \c dest.
+ */
+template<size_t L, size_t M>
+CByteArrayPtr cobsEncode(CByteSlice<L> src, ByteSlice<M> dest) {
+    static_assert(CobsMaxEncodedSize<L>::value <= M, "Destination too short");
+    return CByteArrayPtr(dest.data(), detail::cobsEncode(src.cdata(), L, dest.data()));
+}
+
+/**
+ * \copydoc cobsEncode(CByteSlice<L>, ByteSlice<M>)
+ */
+template<size_t L, size_t M>
+CByteArrayPtr cobsEncode(CByteSlice<L> src, ByteArray<M>& dest) {
+    return cobsEncode(src, dest.slice());
+}
+
+/**
+ * \brief Decode a COBS-encoded frame.
+ *
+ * \param src The encoded bytes, without the \c 0 delimiter.
+ * \param dest Where to put the result.  The decoded frame is always shorter
+ * than the encoded one.
+ * \param size Set to the size of the decoded frame.
+ *
+ * \return \c false iff \c src isn't valid COBS or \c dest is too short.
+ */
+template<size_t M>
+bool cobsDecode(CByteArrayPtr src, ByteSlice<M> dest, size_t& size) {
+    return detail::cobsDecode(src.data(), src.size(), dest.data(), M, size);
+}
+
+/**
+ * \copydoc cobsDecode(CByteArrayPtr, ByteSlice<M>, size_t&)
+ */
+template<size_t M>
+bool cobsDecode(CByteArrayPtr src, ByteArray<M>& dest, size_t& size) {
+    return cobsDecode(src, dest.slice(), size);
+}
+
+/**
+ * \brief SLIP-encode bytes, ending with an \c END byte.
+ *
+ * \param src The bytes to encode.
+ * \param dest Where to put the result.  Its length is statically checked
+ * against \c SlipMaxEncodedSize<L>.
+ *
+ * \return A pointer to the encoded bytes, at the beginning of \c dest.
+ */
+template<size_t L, size_t M>
+CByteArrayPtr slipEncode(CByteSlice<L> src, ByteSlice<M> dest) {
+    static_assert(SlipMaxEncodedSize<L>::value <= M, "Destination too short");
+    return CByteArrayPtr(dest.data(), detail::slipEncode(src.cdata(), L, dest.data()));
+}
+
+/**
+ * \copydoc slipEncode(CByteSlice<L>, ByteSlice<M>)
+ */
+template<size_t L, size_t M>
+CByteArrayPtr slipEncode(CByteSlice<L> src, ByteArray<M>& dest) {
+    return slipEncode(src, dest.slice());
+}
+
+/**
+ * \brief A COBS decoder that is fed one byte at a time, e.g., from a UART
+ * receive interrupt.
+ *
+ * \tparam N The maximum size of a decoded frame.  Longer frames are dropped.
+ *
+ * \code
+ * static safearray::CobsDecoder<64> rx;
+ *
+ * ISR(USART_RX_vect) {
+ *     if (rx.feed(UDR0)) {
+ *         handleFrame(rx.frame());
+ *     }
+ * }
+ * \endcode
+ */
+template<size_t N>
+class CobsDecoder
+{
+public:
+    /**
+     * \brief Make a decoder that's waiting for the start of a frame.
+     */
+    CobsDecoder() : _buf{}, _size(0), _remaining(0), _code(0), _bad(false), _done(false) {}
+
+    /**
+     * \brief This constructor is deleted to prevent accidental copies.
+     */
+    CobsDecoder(const CobsDecoder& other) = delete;
+
+    /**
+     * \brief This method is deleted to prevent accidental copies.
+     */
+    CobsDecoder& operator=(const CobsDecoder& other) = delete;
+
+    /**
+     * \brief Decode the next byte of the stream.
+     *
+     * Malformed and too-long frames are dropped, up to the next \c 0.
+     *
+     * \return \c true iff the byte ended a valid frame, which
+     * \c frame() then points to until the next call.
+     */
+    bool feed(unsigned char b) {
+        if (this->_done) {
+            this->restart();
+        }
+        if (b == 0) {
+            bool ok = !this->_bad && this->_code != 0 && this->_remaining == 0;
+            if (!ok) {
+                this->restart();
+            }
+            this->_done = ok;
+            return ok;
+        }
+        if (this->_bad) {
+            return false;
+        }
+        if (this->_remaining == 0) {
+            if (this->_code != 0 && this->_code != 0xff) {
+                this->append(0);
+            }
+            this->_code = b;
+            this->_remaining = (unsigned char) (b - 1);
+        } else {
+            this->append(b);
+            --this->_remaining;
+        }
+        return false;
+    }
+
+    /**
+     * \brief Make a pointer to the last frame decoded.
+     */
+    CByteArrayPtr frame() const {
+        return CByteArrayPtr(this->_buf.cdata(), this->_size);
+    }
+
+private:
+    void restart() {
+        this->_size = 0;
+        this->_remaining = 0;
+        this->_code = 0;
+        this->_bad = false;
+        this->_done = false;
+    }
+
+    void append(unsigned char b) {
+        if (this->_size == N) {
+            this->_bad = true;
+        } else {
+            this->_buf[this->_size++] = b;
+        }
+    }
+
+    ByteArray<N> _buf;
+    size_t _size;
+    unsigned char _remaining;
+    unsigned char _code;
+    bool _bad;
+    bool _done;
+};
+
+/**
+ * \brief A SLIP decoder that is fed one byte at a time, e.g., from a UART
+ * receive interrupt.
+ *
+ * \tparam N The maximum size of a decoded frame.  Longer frames are dropped.
+ */
+template<size_t N>
+class SlipDecoder
+{
+public:
+    /**
+     * \brief Make a decoder that's waiting for the start of a frame.
+     */
+    SlipDecoder() : _buf{}, _size(0), _escaped(false), _bad(false), _done(false) {}
+
+    /**
+     * \brief This constructor is deleted to prevent accidental copies.
+     */
+    SlipDecoder(const SlipDecoder& other) = delete;
+
+    /**
+     * \brief This method is deleted to prevent accidental copies.
+     */
+    SlipDecoder& operator=(const SlipDecoder& other) = delete;
+
+    /**
+     * \brief Decode the next byte of the stream.
+     *
+     * Malformed and too-long frames are dropped, up to the next \c END.
+     *
+     * \return \c true iff the byte ended a valid, non-empty frame, which
+     * \c frame() then points to until the next call.
+     */
+    bool feed(unsigned char b) {
+        if (this->_done) {
+            this->restart();
+        }
+        if (b == detail::SLIP_END) {
+            bool ok = !this->_bad && !this->_escaped && this->_size > 0;
+            if (!ok) {
+                this->restart();
+            }
+            this->_done = ok;
+            return ok;
+        }
+        if (this->_bad) {
+            return false;
+        }
+        if (this->_escaped) {
+            this->_escaped = false;
+            if (b == detail::SLIP_ESC_END) {
+                b = detail::SLIP_END;
+            } else if (b == detail::SLIP_ESC_ESC) {
+                b = detail::SLIP_ESC;
+            } else {
+                this->_bad = true;
+                return false;
+            }
+        } else if (b == detail::SLIP_ESC) {
+            this->_escaped = true;
+            return false;
+        }
+        if (this->_size == N) {
+            this->_bad = true;
+        } else {
+            this->_buf[this->_size++] = b;
+        }
+        return false;
+    }
+
+    /**
+     * \copydoc CobsDecoder::frame
+     */
+    CByteArrayPtr frame() const {
+        return CByteArrayPtr(this->_buf.cdata(), this->_size);
+    }
+
+private:
+    void restart() {
+        this->_size = 0;
+        this->_escaped = false;
+        this->_bad = false;
+        this->_done = false;
+    }
+
+    ByteArray<N> _buf;
+    size_t _size;
+    bool _escaped;
+    bool _bad;
+    bool _done;
+};
+
+} // namespace safearray
+
+#endif
@@ -0,0 +1,350 @@
+#ifndef __MCU_SAFE_GATHER_H__
+#define __MCU_SAFE_GATHER_H__
+
+/**
+ * \file
+ *
+ * Scatter-gather lists of byte slices, so that frames can be handed to a
+ * driver piece by piece instead of being copied into one buffer first.
+ */
+
+#include "mcu_safe_array.h"
+
+#if defined(__linux__)
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#endif
+
+namespace safearray {
+
+namespace detail {
+
+#if defined(__linux__)
+/**
+ * On Linux, segments are stored as \c iovecs so that they can be passed to
+ * \c writev as they are.
+ */
+typedef struct iovec Segment;
+#else
+struct Segment {
+    void *iov_base;
+    size_t iov_len;
+};
+#endif
+
+} // namespace detail
+
+/**
+ * \brief A list of up to \c N byte segments that make up one logical buffer.
+ *
+ * \tparam N The capacity (i.e., the maximum number of segments).
+ *
+ * The list only points to the segments, so they must outlive it.  Its total
+ * size is known only at runtime; see \c StaticGatherList for a list whose
+ * total size is known at compile-time.
+ *
+ * \code
+ * safearray::GatherList<3> frame;
+ * frame.add(header.cslice());
+ * frame.add(&payload);
+ * frame.add(mac.cslice());
+ * frame.forEach([](safearray::CByteArrayPtr seg) {
+ *     return radio_write(seg.data(), seg.size());
+ * });
+ * \endcode
+ */
+template<size_t N>
+class GatherList
+{
+public:
+    /**
+     * \brief Make an empty list.
+     */
+    GatherList() : _segs{}, _count(0), _size(0) {}
+
+    /**
+     * \brief Get the number of segments.
+     */
+    size_t count() const {
+        return this->_count;
+    }
+
+    /**
+     * \brief Get the capacity.
+     *
+     * \return \c N
+     */
+    constexpr static size_t capacity() {
+        return N;
+    }
+
+    /**
+     * \brief Get the total number of bytes in all the segments.
+     */
+    size_t size() const {
+        return this->_size;
+    }
+
+    /**
+     * \brief Get a segment.
+     *
+     * WARNING: This method does no static or runtime bounds-checking.
+     */
+    CByteArrayPtr operator[](size_t i) const {
+        return CByteArrayPtr((const unsigned char *) this->_segs[i].iov_base,
+                             this->_segs[i].iov_len);
+    }
+
+    /**
+     * \brief Append a segment.
+     *
+     * \return \c false iff the list was full.
+     */
+    template<size_t L>
+    bool add(CByteSlice<L> seg) {
+        return this->addSegment(seg.cdata(), L);
+    }
+
+    /**
+     * \brief Append an empty segment, which does nothing.
+     *
+     * \return \c true
+     */
+    bool add(CByteSlice<0>) {
+        return true;
+    }
+
+    /**
+     * \copydoc GatherList::add(CByteSlice<L>)
+     */
+    template<size_t L>
+    bool add(const ByteArray<L>& seg) {
+        return this->addSegment(seg.cdata(), L);
+    }
+
+    /**
+     * \brief Append a segment whose size is known only at runtime.
+     *
+     * \return \c false iff the list was full.
+     */
+    bool add(CByteArrayPtr seg) {
+        return this->addSegment(seg.data(), seg.size());
+    }
+
+    /**
+     * \brief Remove all segments.
+     */
+    void clear() {
+        this->_count = 0;
+        this->_size = 0;
+    }
+
+    /**
+     * \brief Drop bytes from the front, e.g., after a partial write.
+     *
+     * Segments that are used up are removed, and the first remaining one is
+     * shortened.
+     *
+     * \param n The number of bytes to drop.  Must be \c <= \c size().
+     */
+    void consume(size_t n) {
+        this->_size -= n;
+        size_t i = 0;
+        while (i < this->_count && n >= this->_segs[i].iov_len) {
+            n -= this->_segs[i].iov_len;
+            ++i;
+        }
+        if (i < this->_count) {
+            this->_segs[i].iov_base = (unsigned char *) this->_segs[i].iov_base + n;
+            this->_segs[i].iov_len -= n;
+        }
+        memmove(this->_segs, this->_segs + i, (this->_count - i) * sizeof(detail::Segment));
+        this->_count -= i;
+    }
+
+    /**
+     * \brief Pass each segment in turn to a writer.
+     *
+     * \param write A callable taking a \c CByteArrayPtr and returning
+     * \c false on failure.
+     *
+     * \return \c false iff \c write failed, in which case the remaining
+     * segments weren't passed to it.
+     */
+    template<typename F>
+    bool forEach(F write) const {
+        for (size_t i = 0; i < this->_count; ++i) {
+            if (!write((*this)[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * \brief Copy all the segments, one after the other, to a slice.
+     *
+     * \return \c false (and nothing is copied) iff the slice is shorter
+     * than \c size().
+     */
+    template<size_t L>
+    bool copyTo(ByteSlice<L> dest) const {
+        if (this->_size > L) {
+            return false;
+        }
+        unsigned char *p = dest.data();
+        for (size_t i = 0; i < this->_count; ++i) {
+            memcpy(p, this->_segs[i].iov_base, this->_segs[i].iov_len);
+            p += this->_segs[i].iov_len;
+        }
+        return true;
+    }
+
+    /**
+     * \copydoc GatherList::copyTo
+     */
+    template<size_t L>
+    bool copyTo(ByteArray<L>& dest) const {
+        return this->copyTo(dest.slice());
+    }
+
+#if defined(__linux__)
+    /**
+     * \brief Write all the segments to a file descriptor with a single
+     * \c writev call.
+     *
+     * \return The result of \c writev.  A partial write can be finished
+     * by passing it to \c consume() and calling this again (which
+     * \c StaticGatherList doesn't allow), but \c writeAll() does it all.
+     */
+    ssize_t writev(int fd) const {
+        return ::writev(fd, this->_segs, (int) this->_count);
+    }
+
+    /**
+     * \brief Write all the segments to a file descriptor, calling \c writev
+     * again after partial writes and interruptions.
+     *
+     * The list itself is left as it is.
+     *
+     * \return \c false iff \c writev failed (with \c errno set), or wrote
+     * nothing.
+     */
+    bool writeAll(int fd) const {
+        detail::Segment segs[N];
+        memcpy(segs, this->_segs, sizeof(segs));
+        size_t first = 0;
+        size_t done = 0;
+        for (;;) {
+            // Skip what's been written, including any empty segments.
+            while (first < this->_count && done >= segs[first].iov_len) {
+                done -= segs[first].iov_len;
+                ++first;
+            }
+            if (first == this->_count) {
+                return true;
+            }
+            segs[first].iov_base = (unsigned char *) segs[first].iov_base + done;
+            segs[first].iov_len -= done;
+            ssize_t n = ::writev(fd, segs + first, (int) (this->_count - first));
+            if (n < 0 && errno == EINTR) {
+                done = 0;
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            done = (size_t) n;
+        }
+    }
+#endif
+
+private:
+    bool addSegment(const unsigned char *data, size_t size) {
+        if (this->_count == N) {
+            return false;
+        }
+        this->_segs[this->_count].iov_base = (void *) data;
+        this->_segs[this->_count].iov_len = size;
+        ++this->_count;
+        this->_size += size;
+        return true;
+    }
+
+    detail::Segment _segs[N];
+    size_t _count;
+    size_t _size;
+};
+
+/**
+ * \brief A list of byte segments whose sizes are all known at compile-time.
+ *
+ * \tparam Ls The sizes of the segments.
+ *
+ * Usually made with \c safearray::gather().  Unlike \c GatherList, the
+ * total size is a compile-time constant, so a buffer to copy the segments
+ * into can be statically checked, or sized exactly:
+ *
+ * \code
+ * auto frame = safearray::gather(header.cslice(), payload.cslice(), mac.cslice());
+ * safearray::ByteArray<decltype(frame)::size()> flat = {};
+ * frame.copyTo(flat);
+ * \endcode
+ */
+template<size_t... Ls>
+class StaticGatherList : public GatherList<sizeof...(Ls)>
+{
+public:
+    /**
+     * \brief Make a list of the given segments.
+     */
+    explicit StaticGatherList(CByteSlice<Ls>... segs) {
+        bool added[] = { true, this->add(segs)... };
+        (void) added;
+    }
+
+    /**
+     * \copydoc GatherList::size
+     */
+    constexpr static size_t size() {
+        return detail::sum(Ls...);
+    }
+
+    /**
+     * \brief Copy all the segments, one after the other, to a slice.
+     *
+     * \param dest The slice to copy to.  Its length is statically checked
+     * against \c size().
+     */
+    template<size_t L>
+    void copyTo(ByteSlice<L> dest) const {
+        static_assert(size() <= L, "Bad destination length");
+        GatherList<sizeof...(Ls)>::copyTo(dest);
+    }
+
+    /**
+     * \copydoc StaticGatherList::copyTo
+     */
+    template<size_t L>
+    void copyTo(ByteArray<L>& dest) const {
+        this->copyTo(dest.slice());
+    }
+
+private:
+    using GatherList<sizeof...(Ls)>::add;
+    using GatherList<sizeof...(Ls)>::clear;
+    using GatherList<sizeof...(Ls)>::consume;
+};
+
+/**
+ * \brief Make a \c StaticGatherList of the given slices.
+ */
+template<size_t... Ls>
+StaticGatherList<Ls...> gather(CByteSlice<Ls>... segs) {
+    return StaticGatherList<Ls...>(segs...);
+}
+
+} // namespace safearray
+
+#endif
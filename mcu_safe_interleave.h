@@ -0,0 +1,329 @@
+#ifndef __MCU_SAFE_INTERLEAVE_H__
+#define __MCU_SAFE_INTERLEAVE_H__
+
+/**
+ * \file
+ *
+ * Conversion between interleaved multi-channel samples (e.g., stereo audio
+ * or 3-axis IMU readings) and separate per-channel arrays.
+ */
+
+#include "mcu_safe_array.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+namespace safearray {
+
+namespace detail {
+
+template<size_t N>
+constexpr bool allSize() {
+    return true;
+}
+
+template<size_t N, typename First, typename... Rest>
+constexpr bool allSize() {
+    return First::size() == N && allSize<N, Rest...>();
+}
+
+template<typename T, size_t C, size_t N>
+void deinterleaveScalar(const T *src, T *const *dest, size_t from) {
+    for (size_t i = from; i < N; ++i) {
+        // C is a constant, so this loop is unrolled
+        for (size_t c = 0; c < C; ++c) {
+            dest[c][i] = src[i * C + c];
+        }
+    }
+}
+
+template<typename T, size_t C, size_t N>
+void interleaveScalar(T *dest, const T *const *src, size_t from) {
+    for (size_t i = from; i < N; ++i) {
+        for (size_t c = 0; c < C; ++c) {
+            dest[i * C + c] = src[c][i];
+        }
+    }
+}
+
+/*
+ * Vectorized kernels for 16-bit samples.  Each one handles as many whole
+ * vectors' worth of frames as it can and returns the number of frames it
+ * handled; the rest are done by the scalar loops.
+ */
+
+template<size_t C>
+struct Simd16 {
+    static size_t deinterleave(const void *, void *const *, size_t) {
+        return 0;
+    }
+
+    static size_t interleave(void *, const void *const *, size_t) {
+        return 0;
+    }
+};
+
+#if defined(__SSE2__)
+
+inline __m128i load128(const void *p) {
+    return _mm_loadu_si128((const __m128i *) p);
+}
+
+inline void store128(void *p, __m128i v) {
+    _mm_storeu_si128((__m128i *) p, v);
+}
+
+inline void storeLow64(void *p, __m128i v) {
+    _mm_storel_epi64((__m128i *) p, v);
+}
+
+inline void storeHigh64(void *p, __m128i v) {
+    _mm_storel_epi64((__m128i *) p, _mm_unpackhi_epi64(v, v));
+}
+
+inline __m128i load2x64(const void *lo, const void *hi) {
+    return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *) lo),
+        _mm_loadl_epi64((const __m128i *) hi));
+}
+
+template<>
+struct Simd16<2> {
+    static size_t deinterleave(const void *src, void *const *dest, size_t n) {
+        const uint16_t *s = (const uint16_t *) src;
+        uint16_t *d0 = (uint16_t *) dest[0];
+        uint16_t *d1 = (uint16_t *) dest[1];
+        size_t i = 0;
+        for (; i < n / 8 * 8; i += 8) {
+            __m128i a = load128(s + i * 2);
+            __m128i b = load128(s + i * 2 + 8);
+            // sign-extend each half of each 32-bit frame, then pack the
+            // halves back together; every value fits, so nothing saturates
+            __m128i l = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16),
+                _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+            __m128i r = _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+            store128(d0 + i, l);
+            store128(d1 + i, r);
+        }
+        return i;
+    }
+
+    static size_t interleave(void *dest, const void *const *src, size_t n) {
+        uint16_t *d = (uint16_t *) dest;
+        const uint16_t *s0 = (const uint16_t *) src[0];
+        const uint16_t *s1 = (const uint16_t *) src[1];
+        size_t i = 0;
+        for (; i < n / 8 * 8; i += 8) {
+            __m128i l = load128(s0 + i);
+            __m128i r = load128(s1 + i);
+            store128(d + i * 2, _mm_unpacklo_epi16(l, r));
+            store128(d + i * 2 + 8, _mm_unpackhi_epi16(l, r));
+        }
+        return i;
+    }
+};
+
+template<>
+struct Simd16<4> {
+    static size_t deinterleave(const void *src, void *const *dest, size_t n) {
+        const uint16_t *s = (const uint16_t *) src;
+        uint16_t *d0 = (uint16_t *) dest[0];
+        uint16_t *d1 = (uint16_t *) dest[1];
+        uint16_t *d2 = (uint16_t *) dest[2];
+        uint16_t *d3 = (uint16_t *) dest[3];
+        size_t i = 0;
+        for (; i < n / 4 * 4; i += 4) {
+            // a 4x4 transpose of 16-bit elements
+            __m128i a = load128(s + i * 4);
+            __m128i b = load128(s + i * 4 + 8);
+            __m128i t0 = _mm_unpacklo_epi16(a, b);
+            __m128i t1 = _mm_unpackhi_epi16(a, b);
+            __m128i u0 = _mm_unpacklo_epi16(t0, t1);
+            __m128i u1 = _mm_unpackhi_epi16(t0, t1);
+            storeLow64(d0 + i, u0);
+            storeHigh64(d1 + i, u0);
+            storeLow64(d2 + i, u1);
+            storeHigh64(d3 + i, u1);
+        }
+        return i;
+    }
+
+    static size_t interleave(void *dest, const void *const *src, size_t n) {
+        uint16_t *d = (uint16_t *) dest;
+        const uint16_t *s0 = (const uint16_t *) src[0];
+        const uint16_t *s1 = (const uint16_t *) src[1];
+        const uint16_t *s2 = (const uint16_t *) src[2];
+        const uint16_t *s3 = (const uint16_t *) src[3];
+        size_t i = 0;
+        for (; i < n / 4 * 4; i += 4) {
+            __m128i u0 = load2x64(s0 + i, s1 + i);
+            __m128i u1 = load2x64(s2 + i, s3 + i);
+            __m128i t0 = _mm_unpacklo_epi16(u0, u1);
+            __m128i t1 = _mm_unpackhi_epi16(u0, u1);
+            store128(d + i * 4, _mm_unpacklo_epi16(t0, t1));
+            store128(d + i * 4 + 8, _mm_unpackhi_epi16(t0, t1));
+        }
+        return i;
+    }
+};
+
+#endif // __SSE2__
+
+#if defined(__SSSE3__)
+
+/**
+ * Make a byte-shuffle mask that moves the 16-bit elements of vector
+ * \c reg of an interleaved 3-channel stream that belong to channel \c chan
+ * into place in a vector of 8 consecutive samples of that channel.  With
+ * \c inverse, the mask instead moves samples of channel \c chan into
+ * place in vector \c reg of the interleaved stream.  Lanes that come from
+ * elsewhere are zeroed.
+ */
+inline __m128i shuffle3(size_t chan, size_t reg, bool inverse) {
+    uint8_t m[16];
+    for (size_t k = 0; k < 16; ++k) {
+        size_t lane = k / 2;
+        size_t e, from;
+        if (!inverse) {
+            e = lane * 3 + chan; // index in interleaved stream
+            from = e % 8;
+            m[k] = e / 8 == reg ? (uint8_t) (from * 2 + k % 2) : 0x80;
+        } else {
+            e = reg * 8 + lane; // index in interleaved stream
+            from = e / 3;
+            m[k] = e % 3 == chan ? (uint8_t) (from * 2 + k % 2) : 0x80;
+        }
+    }
+    return load128(m);
+}
+
+template<>
+struct Simd16<3> {
+    static size_t deinterleave(const void *src, void *const *dest, size_t n) {
+        const uint16_t *s = (const uint16_t *) src;
+        __m128i m[3][3];
+        for (size_t c = 0; c < 3; ++c) {
+            for (size_t r = 0; r < 3; ++r) {
+                m[c][r] = shuffle3(c, r, false);
+            }
+        }
+        size_t i = 0;
+        for (; i < n / 8 * 8; i += 8) {
+            __m128i v0 = load128(s + i * 3);
+            __m128i v1 = load128(s + i * 3 + 8);
+            __m128i v2 = load128(s + i * 3 + 16);
+            for (size_t c = 0; c < 3; ++c) {
+                __m128i out = _mm_or_si128(_mm_or_si128(
+                    _mm_shuffle_epi8(v0, m[c][0]), _mm_shuffle_epi8(v1, m[c][1])),
+                    _mm_shuffle_epi8(v2, m[c][2]));
+                store128((uint16_t *) dest[c] + i, out);
+            }
+        }
+        return i;
+    }
+
+    static size_t interleave(void *dest, const void *const *src, size_t n) {
+        uint16_t *d = (uint16_t *) dest;
+        __m128i m[3][3];
+        for (size_t r = 0; r < 3; ++r) {
+            for (size_t c = 0; c < 3; ++c) {
+                m[r][c] = shuffle3(c, r, true);
+            }
+        }
+        size_t i = 0;
+        for (; i < n / 8 * 8; i += 8) {
+            __m128i v0 = load128((const uint16_t *) src[0] + i);
+            __m128i v1 = load128((const uint16_t *) src[1] + i);
+            __m128i v2 = load128((const uint16_t *) src[2] + i);
+            for (size_t r = 0; r < 3; ++r) {
+                __m128i out = _mm_or_si128(_mm_or_si128(
+                    _mm_shuffle_epi8(v0, m[r][0]), _mm_shuffle_epi8(v1, m[r][1])),
+                    _mm_shuffle_epi8(v2, m[r][2]));
+                store128(d + i * 3 + r * 8, out);
+            }
+        }
+        return i;
+    }
+};
+
+#endif // __SSSE3__
+
+template<typename T, size_t C, size_t N, bool Is16 = sizeof(T) == 2>
+struct Channels {
+    static void deinterleave(const T *src, T *const *dest) {
+        deinterleaveScalar<T, C, N>(src, dest, 0);
+    }
+
+    static void interleave(T *dest, const T *const *src) {
+        interleaveScalar<T, C, N>(dest, src, 0);
+    }
+};
+
+template<typename T, size_t C, size_t N>
+struct Channels<T, C, N, true> {
+    static void deinterleave(const T *src, T *const *dest) {
+        size_t done = Simd16<C>::deinterleave(src, (void *const *) dest, N);
+        deinterleaveScalar<T, C, N>(src, dest, done);
+    }
+
+    static void interleave(T *dest, const T *const *src) {
+        size_t done = Simd16<C>::interleave(dest, (const void *const *) src, N);
+        interleaveScalar<T, C, N>(dest, src, done);
+    }
+};
+
+} // namespace detail
+
+/**
+ * \brief Split interleaved samples into one slice per channel.
+ *
+ * The number of channels \c C is the number of destination slices, and
+ * the lengths are statically checked: the source must hold exactly
+ * \c C \c * \c N samples.  16-bit samples with 2, 3 or 4 channels are
+ * shuffled with SIMD instructions on hosts that have them (SSE2, or SSSE3
+ * for 3 channels); everything else uses a loop that the compiler unrolls
+ * over the channels.
+ *
+ * \code
+ * safearray::Array<int16_t, 2 * 64> stereo;
+ * safearray::Array<int16_t, 64> left, right;
+ * safearray::deinterleave(stereo.cslice(), left.slice(), right.slice());
+ * \endcode
+ *
+ * \param src The interleaved samples (frame 0 channel 0, frame 0
+ * channel 1, ...).
+ * \param first The slice to receive channel 0.
+ * \param rest The slices to receive the remaining channels, in order.
+ */
+template<typename T, size_t L, size_t N, typename... Rest>
+void deinterleave(CSlice<T, L> src, Slice<T, N> first, Rest... rest) {
+    static_assert(detail::allSize<N, Rest...>(), "Bad channel length");
+    static_assert(L == (1 + sizeof...(Rest)) * N, "Bad slice length");
+    T *dest[] = { first.data(), rest.data()... };
+    detail::Channels<T, 1 + sizeof...(Rest), N>::deinterleave(src.cdata(), dest);
+}
+
+/**
+ * \brief Merge one slice per channel into interleaved samples.
+ *
+ * The inverse of \c deinterleave, with the same static checks and
+ * kernels.
+ *
+ * \param dest The slice to receive the interleaved samples.
+ * \param first The samples of channel 0.
+ * \param rest The samples of the remaining channels, in order.
+ */
+template<typename T, size_t L, size_t N, typename... Rest>
+void interleave(Slice<T, L> dest, CSlice<T, N> first, Rest... rest) {
+    static_assert(detail::allSize<N, Rest...>(), "Bad channel length");
+    static_assert(L == (1 + sizeof...(Rest)) * N, "Bad slice length");
+    const T *src[] = { first.cdata(), rest.cdata()... };
+    detail::Channels<T, 1 + sizeof...(Rest), N>::interleave(dest.data(), src);
+}
+
+} // namespace safearray
+
+#endif
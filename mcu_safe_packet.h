@@ -0,0 +1,241 @@
+#ifndef __MCU_SAFE_PACKET_H__
+#define __MCU_SAFE_PACKET_H__
+
+/**
+ * \file
+ *
+ * A packet buffer with room reserved in front of the payload, so that each
+ * protocol layer can prepend its header without moving the payload.
+ */
+
+#include "mcu_safe_array.h"
+
+namespace safearray {
+
+/**
+ * \brief A pointer to the bytes of a packet, as seen by one protocol layer.
+ *
+ * \tparam H The headroom, i.e., the number of bytes in front of the packet
+ * that are free for headers.
+ * \tparam C The number of bytes from the start of the packet to the end of
+ * the buffer, which bounds the packet's size.
+ *
+ * Pushing or popping a header gives a new view with different \c H and
+ * \c C, so when the layers are called one after another, running out of
+ * headroom (or popping more than the buffer holds) is caught at
+ * compile-time:
+ *
+ * \code
+ * template<size_t H, size_t C>
+ * void linkSend(safearray::PacketView<H, C> pkt) {
+ *     auto frame = pkt.template pushHeader<4>();
+ *     frame.template header<4>().assign(linkHeader.cslice());
+ *     radio_write(frame.cdata(), frame.size());
+ * }
+ *
+ * template<size_t H, size_t C>
+ * void transportSend(safearray::PacketView<H, C> pkt) {
+ *     auto seg = pkt.template pushHeader<8>();
+ *     writeTransportHeader(seg.template header<8>());
+ *     linkSend(seg);
+ * }
+ * \endcode
+ */
+template<size_t H, size_t C>
+class PacketView
+{
+public:
+    /**
+     * \brief Make a view of a packet that starts at the given location.
+     *
+     * WARNING: This class provides memory-safety only if the given pointer
+     * is preceded by \c H bytes and followed by \c C bytes of the same
+     * buffer.
+     *
+     * \param data A pointer to the start of the packet.
+     * \param size The size of the packet.  Must be \c <= \c C.
+     */
+    PacketView(unsigned char *data, size_t size) : _data(data), _size(size) {}
+
+    /**
+     * \brief Get the size of the packet.
+     */
+    size_t size() const {
+        return this->_size;
+    }
+
+    /**
+     * \brief Get the headroom.
+     *
+     * \return \c H
+     */
+    constexpr static size_t headroom() {
+        return H;
+    }
+
+    /**
+     * \brief Get the maximum size of the packet.
+     *
+     * \return \c C
+     */
+    constexpr static size_t capacity() {
+        return C;
+    }
+
+    /**
+     * \brief Get a pointer to the start of the packet.
+     */
+    const unsigned char *cdata() const {
+        return this->_data;
+    }
+
+    /**
+     * \copydoc PacketView::cdata
+     */
+    unsigned char *data() {
+        return this->_data;
+    }
+
+    /**
+     * \brief Make a pointer to the bytes of the packet.
+     */
+    CByteArrayPtr operator&() const {
+        return CByteArrayPtr(this->_data, this->_size);
+    }
+
+    /**
+     * \brief Make a slice pointing to the first \c N bytes of the packet.
+     *
+     * \tparam N The size of the header.  Statically checked to be
+     * \c <= \c C.
+     */
+    template<size_t N>
+    CByteSlice<N> cheader() const {
+        static_assert(N <= C, "Bad header size");
+        return CByteSlice<N>(this->_data);
+    }
+
+    /**
+     * \copydoc PacketView::cheader
+     */
+    template<size_t N>
+    ByteSlice<N> header() {
+        static_assert(N <= C, "Bad header size");
+        return ByteSlice<N>(this->_data);
+    }
+
+    /**
+     * \brief Make room for a header in front of the packet.
+     *
+     * The header's bytes are left as they are; fill them in through
+     * \c header<N>() of the returned view.
+     *
+     * \tparam N The size of the header.  Statically checked to be
+     * \c <= \c H.
+     *
+     * \return A view of the packet, starting with the new header.
+     */
+    template<size_t N>
+    PacketView<H - N, C + N> pushHeader() {
+        static_assert(N <= H, "Not enough headroom");
+        return PacketView<H - N, C + N>(this->_data - N, this->_size + N);
+    }
+
+    /**
+     * \brief Remove a header from the front of the packet.
+     *
+     * If the packet is shorter than \c N, the returned view is empty, so
+     * check \c size() first to tell a truncated packet from an empty one.
+     *
+     * \tparam N The size of the header.  Statically checked to be
+     * \c <= \c C.
+     *
+     * \return A view of the rest of the packet.
+     */
+    template<size_t N>
+    PacketView<H + N, C - N> popHeader() {
+        static_assert(N <= C, "Bad header size");
+        return PacketView<H + N, C - N>(this->_data + N,
+                                        this->_size < N ? 0 : this->_size - N);
+    }
+
+private:
+    unsigned char *_data;
+    size_t _size;
+};
+
+/**
+ * \brief A buffer for one packet, with room reserved in front of the
+ * payload for headers.
+ *
+ * \tparam Headroom The number of bytes reserved for headers.
+ * \tparam Capacity The maximum size of the payload.
+ *
+ * To send, write the payload to \c payload(), then hand \c tx() down the
+ * protocol stack; each layer calls \c pushHeader() on the view it gets.
+ * To receive, read a frame into \c raw(), then hand \c rx() up the stack;
+ * each layer calls \c popHeader().
+ */
+template<size_t Headroom, size_t Capacity>
+class PacketBuffer
+{
+public:
+    /**
+     * \brief Make a buffer filled with zeros.
+     */
+    PacketBuffer() : _buf{} {}
+
+    /**
+     * \brief This constructor is deleted to prevent accidental copies.
+     */
+    PacketBuffer(const PacketBuffer& other) = delete;
+
+    /**
+     * \brief This method is deleted to prevent accidental copies.
+     */
+    PacketBuffer& operator=(const PacketBuffer& other) = delete;
+
+    /**
+     * \brief Make a slice pointing to the space for the payload, i.e.,
+     * everything after the headroom.
+     */
+    ByteSlice<Capacity> payload() {
+        return this->_buf.template slice<Headroom>();
+    }
+
+    /**
+     * \brief Make a slice pointing to the whole buffer, e.g., to receive
+     * a frame into.
+     */
+    ByteSlice<Headroom + Capacity> raw() {
+        return this->_buf.slice();
+    }
+
+    /**
+     * \brief Make a view of an outgoing packet whose payload was written
+     * to \c payload().
+     *
+     * \param size The size of the payload.  Must be \c <= \c Capacity.
+     */
+    PacketView<Headroom, Capacity> tx(size_t size) {
+        return PacketView<Headroom, Capacity>(this->_buf.data() + Headroom, size);
+    }
+
+    /**
+     * \brief Make a view of an incoming frame that was written to
+     * \c raw().
+     *
+     * \param size The size of the frame.  Must be
+     * \c <= \c Headroom \c + \c Capacity.
+     */
+    PacketView<0, Headroom + Capacity> rx(size_t size) {
+        return PacketView<0, Headroom + Capacity>(this->_buf.data(), size);
+    }
+
+private:
+    ByteArray<Headroom + Capacity> _buf;
+};
+
+} // namespace safearray
+
+#endif
@@ -0,0 +1,335 @@
+#ifndef __MCU_SAFE_PARSE_H__
+#define __MCU_SAFE_PARSE_H__
+
+/**
+ * \file
+ *
+ * Parsing integers and fixed-point numbers straight out of received text,
+ * without copying them into \c NUL-terminated strings or using \c errno.
+ */
+
+#include "mcu_safe_string.h"
+
+namespace safearray {
+
+/**
+ * \brief The result of parsing a number.
+ */
+enum class ParseResult {
+    /**
+     * The whole text was a number, and it fit.
+     */
+    OK,
+
+    /**
+     * The text was empty.
+     */
+    EMPTY,
+
+    /**
+     * The text had something in it that doesn't belong in a number.
+     */
+    INVALID,
+
+    /**
+     * The text was a number, but it doesn't fit in the type.
+     */
+    OUT_OF_RANGE,
+};
+
+namespace detail {
+
+#if !defined(__AVR__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#if UINTPTR_MAX > 0xffffffffu
+/**
+ * The number of digits converted at once.
+ */
+const size_t PARSE_CHUNK_DIGITS = 8;
+
+inline bool parseChunk(const char *p, uint32_t& value) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    if ((v & 0xf0f0f0f0f0f0f0f0u) != 0x3030303030303030u
+            || ((v + 0x0606060606060606u) & 0xf0f0f0f0f0f0f0f0u) != 0x3030303030303030u) {
+        return false;
+    }
+    v -= 0x3030303030303030u;
+    // Combine neighbouring digits, then pairs, then quads.
+    v = v * 10 + (v >> 8);
+    v = ((v & 0x000000ff000000ffu) * (100 + (1000000ull << 32))
+         + ((v >> 16) & 0x000000ff000000ffu) * (1 + (10000ull << 32))) >> 32;
+    value = (uint32_t) v;
+    return true;
+}
+#else
+const size_t PARSE_CHUNK_DIGITS = 4;
+
+inline bool parseChunk(const char *p, uint32_t& value) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    if ((v & 0xf0f0f0f0u) != 0x30303030u || ((v + 0x06060606u) & 0xf0f0f0f0u) != 0x30303030u) {
+        return false;
+    }
+    v -= 0x30303030u;
+    v = v * 10 + (v >> 8);
+    value = (v & 0xff) * 100 + ((v >> 16) & 0xff);
+    return true;
+}
+#endif
+
+constexpr uint32_t parseChunkScale(size_t digits) {
+    return digits == 0 ? 1 : 10 * parseChunkScale(digits - 1);
+}
+#endif
+
+/**
+ * Accumulate \c n decimal digits, which the caller guarantees fit in \c U.
+ *
+ * \return \c false iff one of them isn't a digit.
+ */
+template<typename U>
+bool accumulateDigits(const char *p, size_t n, U& value) {
+    U acc = 0;
+    size_t i = 0;
+#if !defined(__AVR__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (sizeof(U) >= 4) {
+        for (; i + PARSE_CHUNK_DIGITS <= n; i += PARSE_CHUNK_DIGITS) {
+            uint32_t chunk;
+            if (!parseChunk(p + i, chunk)) {
+                return false;
+            }
+            acc = (U) (acc * parseChunkScale(PARSE_CHUNK_DIGITS) + chunk);
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        unsigned d = (unsigned) (unsigned char) p[i] - '0';
+        if (d > 9) {
+            return false;
+        }
+        acc = (U) (acc * 10 + d);
+    }
+    value = acc;
+    return true;
+}
+
+/**
+ * Parse \c n decimal digits into a value no greater than \c limit, which has
+ * \c D digits.  If \c Checked is \c false, the caller guarantees that
+ * \c n \c < \c D, so the value can't be too big.
+ */
+template<size_t D, bool Checked, typename U>
+ParseResult parseDigits(const char *p, size_t n, U limit, U& value) {
+    if (n == 0) {
+        return ParseResult::INVALID;
+    }
+    if (!Checked || n < D) {
+        return accumulateDigits(p, n, value) ? ParseResult::OK : ParseResult::INVALID;
+    }
+    while (n > D && *p == '0') {
+        ++p;
+        --n;
+    }
+    if (n > D) {
+        U ignored;
+        return accumulateDigits(p, n, ignored) ? ParseResult::OUT_OF_RANGE : ParseResult::INVALID;
+    }
+    U acc = 0;
+    unsigned d = (unsigned) (unsigned char) p[n - 1] - '0';
+    if (!accumulateDigits(p, n - 1, acc) || d > 9) {
+        return ParseResult::INVALID;
+    }
+    if (n == D && (acc > limit / 10 || (acc == limit / 10 && d > limit % 10))) {
+        return ParseResult::OUT_OF_RANGE;
+    }
+    value = (U) (acc * 10 + d);
+    return ParseResult::OK;
+}
+
+/**
+ * The unsigned type that holds the magnitude of an \c I.
+ */
+template<typename I>
+struct ParseUInt {
+    typedef typename FormatUInt<sizeof(I)>::type type;
+};
+
+template<typename I, bool Checked>
+ParseResult parseUInt(const char *p, size_t n, I& value) {
+    static_assert(!isSigned<I>(), "Integer type is signed");
+    typedef typename ParseUInt<I>::type U;
+    const size_t D = decimalDigits((uint64_t) maxValue<I>());
+    if (n == 0) {
+        return ParseResult::EMPTY;
+    }
+    U u;
+    ParseResult r = parseDigits<D, Checked>(p, n, (U) maxValue<I>(), u);
+    if (r == ParseResult::OK) {
+        value = (I) u;
+    }
+    return r;
+}
+
+template<typename I, bool Checked>
+ParseResult parseInt(const char *p, size_t n, I& value) {
+    static_assert(isSigned<I>(), "Integer type is unsigned");
+    typedef typename ParseUInt<I>::type U;
+    const size_t D = decimalDigits((uint64_t) maxValue<I>());
+    if (n == 0) {
+        return ParseResult::EMPTY;
+    }
+    bool neg = *p == '-';
+    if (neg || *p == '+') {
+        ++p;
+        --n;
+    }
+    U u;
+    ParseResult r = parseDigits<D, Checked>(p, n, (U) ((U) maxValue<I>() + neg), u);
+    if (r == ParseResult::OK) {
+        // -u may not fit in an I, but -(u - 1) - 1 does.
+        value = neg && u != 0 ? (I) (0 - (I) (u - 1) - 1) : (I) u;
+    }
+    return r;
+}
+
+template<unsigned Q, typename I>
+ParseResult parseFixed(const char *p, size_t n, I& value) {
+    static_assert(isSigned<I>(), "Integer type is unsigned");
+    static_assert(Q < sizeof(I) * 8 && Q <= 31, "Bad number of fractional bits");
+    typedef typename ParseUInt<I>::type U;
+    const size_t D = decimalDigits((uint64_t) maxValue<I>() >> Q);
+    // Wide enough for a digit times 2^(Q + 1), plus the bits so far.
+    typedef typename FormatUInt<(Q < 28 ? 4 : 8)>::type F;
+    if (n == 0) {
+        return ParseResult::EMPTY;
+    }
+    bool neg = *p == '-';
+    if (neg || *p == '+') {
+        ++p;
+        --n;
+    }
+    U limit = (U) ((U) maxValue<I>() + neg);
+    const char *dot = (const char *) memchr(p, '.', n);
+    size_t intDigits = dot != nullptr ? (size_t) (dot - p) : n;
+    size_t fracDigits = dot != nullptr ? n - intDigits - 1 : 0;
+    if (intDigits + fracDigits == 0) {
+        return ParseResult::INVALID;
+    }
+    U whole = 0;
+    ParseResult r = ParseResult::OK;
+    if (intDigits > 0) {
+        r = parseDigits<D, true>(p, intDigits, (U) (limit >> Q), whole);
+        if (r == ParseResult::INVALID) {
+            return r;
+        }
+    }
+    // Work out the fraction times 2^(Q + 1), rounded down, from the last
+    // digit to the first.  Each step divides by 10 rounding down, but that
+    // gives the same result as rounding down once at the end, so all the
+    // digits count and there's one extra bit to round by.
+    F frac = 0;
+    for (size_t i = fracDigits; i > 0; --i) {
+        unsigned d = (unsigned) (unsigned char) dot[i] - '0';
+        if (d > 9) {
+            return ParseResult::INVALID;
+        }
+        frac = (F) ((((F) d << (Q + 1)) + frac) / 10);
+    }
+    // As in parseDigits, all the digits are checked before overflow is
+    // reported.
+    if (r != ParseResult::OK) {
+        return r;
+    }
+    U fracBits = (U) ((frac + 1) >> 1);
+    U u = (U) (whole << Q);
+    if (fracBits > limit - u) {
+        return ParseResult::OUT_OF_RANGE;
+    }
+    u = (U) (u + fracBits);
+    value = neg && u != 0 ? (I) (0 - (I) (u - 1) - 1) : (I) u;
+    return ParseResult::OK;
+}
+
+} // namespace detail
+
+/**
+ * \brief Parse an unsigned decimal integer.
+ *
+ * \tparam I An unsigned integer type.
+ * \param s The text, which must be nothing but digits.  Leading zeros are
+ * allowed.  If \c L has fewer digits than the largest \c I, the check for
+ * overflow is left out at compile-time.
+ * \param value Set to the number, unless there's an error.
+ */
+template<typename I, size_t L>
+ParseResult parseUInt(CSlice<char, L> s, I& value) {
+    return detail::parseUInt<I, (L >= detail::decimalDigits((uint64_t) detail::maxValue<I>()))>(
+        s.cdata(), L, value);
+}
+
+/**
+ * \brief Parse an unsigned decimal integer.
+ *
+ * \copydetails parseUInt(CSlice<char, L>, I&)
+ */
+template<typename I>
+ParseResult parseUInt(CArrayPtr<char> s, I& value) {
+    return detail::parseUInt<I, true>(s.data(), s.size(), value);
+}
+
+/**
+ * \brief Parse a signed decimal integer.
+ *
+ * \tparam I A signed integer type.
+ * \param s The text, which must be an optional \c '+' or \c '-' followed by
+ * digits.  If \c L has fewer digits than the largest \c I, the check for
+ * overflow is left out at compile-time.
+ * \param value Set to the number, unless there's an error.
+ */
+template<typename I, size_t L>
+ParseResult parseInt(CSlice<char, L> s, I& value) {
+    return detail::parseInt<I, (L >= detail::decimalDigits((uint64_t) detail::maxValue<I>()))>(
+        s.cdata(), L, value);
+}
+
+/**
+ * \brief Parse a signed decimal integer.
+ *
+ * \copydetails parseInt(CSlice<char, L>, I&)
+ */
+template<typename I>
+ParseResult parseInt(CArrayPtr<char> s, I& value) {
+    return detail::parseInt<I, true>(s.data(), s.size(), value);
+}
+
+/**
+ * \brief Parse a decimal number (e.g., \c "-0.25") into a fixed-point value
+ * with \c Q fractional bits, rounding to the nearest.
+ *
+ * \tparam Q The number of fractional bits, e.g., \c 15 for Q15 in an
+ * \c int16_t.  It's statically checked to be less than the number of bits
+ * in \c I, and at most \c 31.
+ * \tparam I A signed integer type.
+ * \param s The text, which must be an optional \c '+' or \c '-', then
+ * digits with an optional \c '.' among them.  All the fractional digits
+ * are taken into account when rounding.
+ * \param value Set to the number times \c 2^Q, unless there's an error.
+ */
+template<unsigned Q, typename I, size_t L>
+ParseResult parseFixed(CSlice<char, L> s, I& value) {
+    return detail::parseFixed<Q>(s.cdata(), L, value);
+}
+
+/**
+ * \brief Parse a decimal number into a fixed-point value.
+ *
+ * \copydetails parseFixed(CSlice<char, L>, I&)
+ */
+template<unsigned Q, typename I>
+ParseResult parseFixed(CArrayPtr<char> s, I& value) {
+    return detail::parseFixed<Q>(s.data(), s.size(), value);
+}
+
+} // namespace safearray
+
+#endif
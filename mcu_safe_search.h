@@ -0,0 +1,421 @@
+#ifndef __MCU_SAFE_SEARCH_H__
+#define __MCU_SAFE_SEARCH_H__
+
+/**
+ * \file
+ *
+ * Searching slices of bytes (or \c chars) for delimiters and sync words,
+ * a vector or a word at a time.
+ */
+
+#include "mcu_safe_array.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace safearray {
+
+namespace detail {
+
+#if !defined(__AVR__) && !defined(__SSE2__)
+/**
+ * The word type for SWAR ("SIMD within a register") scanning.
+ */
+#if UINTPTR_MAX > 0xffffffffu
+typedef uint64_t SearchWord;
+#else
+typedef uint32_t SearchWord;
+#endif
+
+const SearchWord SEARCH_ONES = (SearchWord) -1 / 0xff;
+const SearchWord SEARCH_HIGHS = SEARCH_ONES * 0x80;
+
+inline SearchWord loadSearchWord(const unsigned char *p) {
+    SearchWord w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+/**
+ * A word with the high bit set in (at least) the lowest byte of \c x that is
+ * \c 0.  Bytes above that one may be flagged spuriously.
+ */
+inline SearchWord zeroBytesApprox(SearchWord x) {
+    return (x - SEARCH_ONES) & ~x & SEARCH_HIGHS;
+}
+
+/**
+ * A word with the high bit set in exactly the bytes of \c x that are \c 0.
+ */
+inline SearchWord zeroBytesExact(SearchWord x) {
+    return ~(((x & ~SEARCH_HIGHS) + ~SEARCH_HIGHS) | x) & SEARCH_HIGHS;
+}
+
+/**
+ * The index of the first byte flagged in a word from \c zeroBytesApprox().
+ */
+inline size_t firstFlaggedByte(SearchWord flags, const unsigned char *p,
+                               const unsigned char *needles, size_t k) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    (void) p;
+    (void) needles;
+    (void) k;
+    return (size_t) __builtin_ctzll(flags) / 8;
+#else
+    // The flags are in memory order only on little-endian CPUs.
+    (void) flags;
+    for (size_t i = 0;; ++i) {
+        for (size_t j = 0; j < k; ++j) {
+            if (p[i] == needles[j]) {
+                return i;
+            }
+        }
+    }
+#endif
+}
+#endif
+
+/**
+ * Find the first of \c n bytes that equals any of the \c K needles.
+ *
+ * \return The index of the byte, or \c n if there is none.
+ */
+template<size_t K>
+size_t findAny(const unsigned char *p, size_t n, const unsigned char *needles) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256i vneedles[K];
+    for (size_t j = 0; j < K; ++j) {
+        vneedles[j] = _mm256_set1_epi8((char) needles[j]);
+    }
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (p + i));
+        __m256i m = _mm256_cmpeq_epi8(v, vneedles[0]);
+        for (size_t j = 1; j < K; ++j) {
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, vneedles[j]));
+        }
+        unsigned bits = (unsigned) _mm256_movemask_epi8(m);
+        if (bits != 0) {
+            return i + (size_t) __builtin_ctz(bits);
+        }
+    }
+#elif defined(__SSE2__)
+    __m128i vneedles[K];
+    for (size_t j = 0; j < K; ++j) {
+        vneedles[j] = _mm_set1_epi8((char) needles[j]);
+    }
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (p + i));
+        __m128i m = _mm_cmpeq_epi8(v, vneedles[0]);
+        for (size_t j = 1; j < K; ++j) {
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(v, vneedles[j]));
+        }
+        unsigned bits = (unsigned) _mm_movemask_epi8(m);
+        if (bits != 0) {
+            return i + (size_t) __builtin_ctz(bits);
+        }
+    }
+#elif !defined(__AVR__)
+    SearchWord patterns[K];
+    for (size_t j = 0; j < K; ++j) {
+        patterns[j] = SEARCH_ONES * needles[j];
+    }
+    for (; i + sizeof(SearchWord) <= n; i += sizeof(SearchWord)) {
+        SearchWord w = loadSearchWord(p + i);
+        SearchWord flags = 0;
+        for (size_t j = 0; j < K; ++j) {
+            flags |= zeroBytesApprox(w ^ patterns[j]);
+        }
+        if (flags != 0) {
+            return i + firstFlaggedByte(flags, p + i, needles, K);
+        }
+    }
+#endif
+    // On AVR, bytes are as wide as registers, so this is as good as it gets.
+    for (; i < n; ++i) {
+        for (size_t j = 0; j < K; ++j) {
+            if (p[i] == needles[j]) {
+                return i;
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * Count the bytes of \c p that equal \c b.
+ */
+inline size_t countByte(const unsigned char *p, size_t n, unsigned char b) {
+    size_t count = 0;
+    size_t i = 0;
+    // Matches are summed per byte lane, and the lanes are added up before
+    // any of them can overflow.
+#if defined(__AVX2__)
+    __m256i vb = _mm256_set1_epi8((char) b);
+    while (i + 32 <= n) {
+        __m256i sums = _mm256_setzero_si256();
+        for (size_t j = 0; j < 255 && i + 32 <= n; ++j, i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *) (p + i));
+            sums = _mm256_sub_epi8(sums, _mm256_cmpeq_epi8(v, vb));
+        }
+        __m256i total = _mm256_sad_epu8(sums, _mm256_setzero_si256());
+        count += (size_t) (_mm256_extract_epi64(total, 0) + _mm256_extract_epi64(total, 1)
+                           + _mm256_extract_epi64(total, 2) + _mm256_extract_epi64(total, 3));
+    }
+#elif defined(__SSE2__)
+    __m128i vb = _mm_set1_epi8((char) b);
+    while (i + 16 <= n) {
+        __m128i sums = _mm_setzero_si128();
+        for (size_t j = 0; j < 255 && i + 16 <= n; ++j, i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (p + i));
+            sums = _mm_sub_epi8(sums, _mm_cmpeq_epi8(v, vb));
+        }
+        __m128i total = _mm_sad_epu8(sums, _mm_setzero_si128());
+        count += (size_t) (_mm_cvtsi128_si32(total)
+                           + _mm_cvtsi128_si32(_mm_unpackhi_epi64(total, total)));
+    }
+#elif !defined(__AVR__)
+    SearchWord pattern = SEARCH_ONES * b;
+    while (i + sizeof(SearchWord) <= n) {
+        SearchWord sums = 0;
+        for (size_t j = 0; j < 255 && i + sizeof(SearchWord) <= n;
+                ++j, i += sizeof(SearchWord)) {
+            sums += zeroBytesExact(loadSearchWord(p + i) ^ pattern) >> 7;
+        }
+        for (size_t k = 0; k < sizeof(SearchWord); ++k) {
+            count += (size_t) ((sums >> (8 * k)) & 0xff);
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        count += p[i] == b;
+    }
+    return count;
+}
+
+/**
+ * Find the first occurrence of the \c k bytes at \c needle, by looking for
+ * its first byte and then comparing the rest.
+ */
+inline size_t findSequence(const unsigned char *p, size_t n, const unsigned char *needle,
+                           size_t k) {
+    if (k == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i + k <= n; ++i) {
+        i += findAny<1>(p + i, n - k + 1 - i, needle);
+        if (i + k > n) {
+            break;
+        }
+        if (memcmp(p + i + 1, needle + 1, k - 1) == 0) {
+            return i;
+        }
+    }
+    return n;
+}
+
+constexpr size_t horspoolPick(size_t later, bool match, size_t skip, size_t k) {
+    return later != k ? later : (match ? skip : k);
+}
+
+constexpr size_t horspoolSkip(unsigned char, size_t k, size_t) {
+    return k;
+}
+
+/**
+ * The Horspool shift for byte \c c, given the needle bytes from index \c i
+ * on: the distance from the last occurrence of \c c (not counting the final
+ * byte) to the end of the needle, or \c k if there's none.
+ */
+template<typename... Bs>
+constexpr size_t horspoolSkip(unsigned char c, size_t k, size_t i, unsigned char b, Bs... rest) {
+    return sizeof...(rest) == 0
+        ? k
+        : horspoolPick(horspoolSkip(c, k, i + 1, rest...), b == c, k - 1 - i, k);
+}
+
+template<typename Is, unsigned char... Needle>
+struct HorspoolTableImpl;
+
+template<size_t... Is, unsigned char... Needle>
+struct HorspoolTableImpl<Indices<Is...>, Needle...> {
+    static constexpr Array<uint8_t, 256> skip = {{
+        (uint8_t) horspoolSkip((unsigned char) Is, sizeof...(Needle), 0, Needle...)...
+    }};
+};
+
+template<size_t... Is, unsigned char... Needle>
+constexpr Array<uint8_t, 256> HorspoolTableImpl<Indices<Is...>, Needle...>::skip SAFEARRAY_PROGMEM;
+
+} // namespace detail
+
+/**
+ * \brief The bytes of a search pattern known at compile-time, with its
+ * Horspool shift table, both generated at compile-time.
+ *
+ * \tparam Needle The bytes to search for.  There must be between \c 1 and
+ * \c 255 of them.
+ */
+template<unsigned char... Needle>
+struct HorspoolTable {
+    static_assert(sizeof...(Needle) > 0 && sizeof...(Needle) <= 255, "Bad needle length");
+
+    /**
+     * The needle.
+     */
+    static constexpr Array<unsigned char, sizeof...(Needle)> needle = {{Needle...}};
+
+    /**
+     * For each byte value, how far the needle can be moved when that byte
+     * is under its last position and there's no match.  It's in flash on
+     * AVR, so read it with \c SAFEARRAY_READ_PROGMEM_BYTE.
+     */
+    static constexpr const Array<uint8_t, 256>& skip =
+        detail::HorspoolTableImpl<typename detail::MakeIndices<256>::type, Needle...>::skip;
+};
+
+template<unsigned char... Needle>
+constexpr Array<unsigned char, sizeof...(Needle)> HorspoolTable<Needle...>::needle;
+
+template<unsigned char... Needle>
+constexpr const Array<uint8_t, 256>& HorspoolTable<Needle...>::skip;
+
+/**
+ * \brief Find the first element equal to a value.
+ *
+ * \tparam T A byte-sized type, e.g., \c char or \c unsigned \c char.
+ *
+ * \return The index of the element, or \c L if there is none.
+ */
+template<typename T, size_t L>
+size_t find(CSlice<T, L> s, T v) {
+    static_assert(sizeof(T) == 1, "Bad element type");
+    unsigned char b = (unsigned char) v;
+    return detail::findAny<1>((const unsigned char *) s.cdata(), L, &b);
+}
+
+/**
+ * \brief Find the first element equal to a value.
+ *
+ * \return The index of the element, or \c s.size() if there is none.
+ */
+template<typename T>
+size_t find(CArrayPtr<T> s, T v) {
+    static_assert(sizeof(T) == 1, "Bad element type");
+    unsigned char b = (unsigned char) v;
+    return detail::findAny<1>((const unsigned char *) s.data(), s.size(), &b);
+}
+
+/**
+ * \brief Find the first element equal to any of a few values.
+ *
+ * \param values The values to look for.  Each one costs a comparison per
+ * element, so keep this short.
+ *
+ * \return The index of the element, or \c L if there is none.
+ */
+template<typename T, size_t L, size_t K>
+size_t findAny(CSlice<T, L> s, CSlice<T, K> values) {
+    static_assert(sizeof(T) == 1, "Bad element type");
+    static_assert(K > 0, "No values to find");
+    return detail::findAny<K>((const unsigned char *) s.cdata(), L,
+                              (const unsigned char *) values.cdata());
+}
+
+/**
+ * \brief Find the first element equal to any of a few values.
+ *
+ * \return The index of the element, or \c s.size() if there is none.
+ */
+template<typename T, size_t K>
+size_t findAny(CArrayPtr<T> s, CSlice<T, K> values) {
+    static_assert(sizeof(T) == 1, "Bad element type");
+    static_assert(K > 0, "No values to find");
+    return detail::findAny<K>((const unsigned char *) s.data(), s.size(),
+                              (const unsigned char *) values.cdata());
+}
+
+/**
+ * \brief Count the elements equal to a value.
+ */
+template<typename T, size_t L>
+size_t count(CSlice<T, L> s, T v) {
+    static_assert(sizeof(T) == 1, "Bad element type");
+    return detail::countByte((const unsigned char *) s.cdata(), L, (unsigned char) v);
+}
+
+/**
+ * \copydoc count(CSlice<T, L>, T)
+ */
+template<typename T>
+size_t count(CArrayPtr<T> s, T v) {
+    static_assert(sizeof(T) == 1, "Bad element type");
+    return detail::countByte((const unsigned char *) s.data(), s.size(), (unsigned char) v);
+}
+
+/**
+ * \brief Find the first occurrence of a sequence of elements.
+ *
+ * \param needle The sequence to look for.  Its length is statically checked
+ * to be \c <= \c L.
+ *
+ * \return The index where the sequence starts, or \c L if it doesn't occur.
+ */
+template<typename T, size_t L, size_t K>
+size_t findSequence(CSlice<T, L> s, CSlice<T, K> needle) {
+    static_assert(sizeof(T) == 1, "Bad element type");
+    static_assert(K <= L, "Needle longer than slice");
+    return detail::findSequence((const unsigned char *) s.cdata(), L,
+                                (const unsigned char *) needle.cdata(), K);
+}
+
+/**
+ * \brief Find the first occurrence of a sequence of elements.
+ *
+ * \return The index where the sequence starts, or \c s.size() if it doesn't
+ * occur.
+ */
+template<typename T, size_t K>
+size_t findSequence(CArrayPtr<T> s, CSlice<T, K> needle) {
+    static_assert(sizeof(T) == 1, "Bad element type");
+    return detail::findSequence((const unsigned char *) s.data(), s.size(),
+                                (const unsigned char *) needle.cdata(), K);
+}
+
+/**
+ * \brief Find the first occurrence of a sequence of bytes known at
+ * compile-time, e.g., a sync word, with the Boyer-Moore-Horspool algorithm.
+ *
+ * \code
+ * size_t start = safearray::findSequence<0xd3, 0x91>(rx.cslice());
+ * \endcode
+ *
+ * \tparam Needle The bytes to look for.  Their number is statically checked
+ * to be \c <= \c L.
+ *
+ * \return The index where the sequence starts, or \c L if it doesn't occur.
+ */
+template<unsigned char... Needle, typename T, size_t L>
+size_t findSequence(CSlice<T, L> s) {
+    static_assert(sizeof(T) == 1, "Bad element type");
+    static_assert(sizeof...(Needle) <= L, "Needle longer than slice");
+    typedef HorspoolTable<Needle...> Table;
+    const size_t k = sizeof...(Needle);
+    const unsigned char *p = (const unsigned char *) s.cdata();
+    const unsigned char *needle = Table::needle.cdata();
+    for (size_t i = 0; i + k <= L;) {
+        unsigned char last = p[i + k - 1];
+        if (last == needle[k - 1] && memcmp(p + i, needle, k - 1) == 0) {
+            return i;
+        }
+        i += SAFEARRAY_READ_PROGMEM_BYTE(Table::skip.cdata() + last);
+    }
+    return L;
+}
+
+} // namespace safearray
+
+#endif
@@ -0,0 +1,379 @@
+#ifndef __MCU_SAFE_SHA256_H__
+#define __MCU_SAFE_SHA256_H__
+
+/**
+ * \file
+ *
+ * Streaming SHA-256 and HMAC-SHA256 with all their state inside the object.
+ */
+
+#include "mcu_safe_checksum.h"
+
+namespace safearray {
+
+namespace detail {
+
+/**
+ * The SHA-256 round constants.
+ */
+template<typename Dummy = void>
+struct Sha256Constants {
+    static const uint32_t k[64];
+};
+
+template<typename Dummy>
+const uint32_t Sha256Constants<Dummy>::k[64] SAFEARRAY_PROGMEM = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+inline uint32_t rotr(uint32_t x, unsigned n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+inline uint32_t loadBigEndian32(const unsigned char *p) {
+    return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | p[3];
+}
+
+inline void storeBigEndian32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char) (v >> 24);
+    p[1] = (unsigned char) (v >> 16);
+    p[2] = (unsigned char) (v >> 8);
+    p[3] = (unsigned char) v;
+}
+
+/**
+ * Get word \c i of the message schedule, which is kept as a ring of the
+ * last 16 words instead of all 64.
+ */
+inline uint32_t sha256Schedule(uint32_t *w, unsigned i) {
+    if (i < 16) {
+        return w[i];
+    }
+    uint32_t w2 = w[(i - 2) & 15];
+    uint32_t w15 = w[(i - 15) & 15];
+    w[i & 15] += (rotr(w2, 17) ^ rotr(w2, 19) ^ (w2 >> 10))
+        + w[(i - 7) & 15]
+        + (rotr(w15, 7) ^ rotr(w15, 18) ^ (w15 >> 3));
+    return w[i & 15];
+}
+
+/**
+ * One round, written so that the caller can rotate the roles of the eight
+ * working variables instead of moving their values.
+ */
+inline void sha256Round(uint32_t a, uint32_t b, uint32_t c, uint32_t& d,
+                        uint32_t e, uint32_t f, uint32_t g, uint32_t& h,
+                        uint32_t *w, unsigned i) {
+    uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g))
+        + SAFEARRAY_READ_PROGMEM_DWORD(Sha256Constants<>::k + i) + sha256Schedule(w, i);
+    uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    d += t1;
+    h = t1 + t2;
+}
+
+/**
+ * Add a 64-byte block to the hash state.
+ */
+inline void sha256Compress(uint32_t *state, const unsigned char *block) {
+    uint32_t w[16];
+    for (unsigned i = 0; i < 16; ++i) {
+        w[i] = loadBigEndian32(block + 4 * i);
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+#if defined(__AVR__)
+    // One round per iteration, moving the values down, so that the code
+    // stays small; the rounds are dominated by 32-bit arithmetic anyway.
+    for (unsigned i = 0; i < 64; ++i) {
+        sha256Round(a, b, c, d, e, f, g, h, w, i);
+        uint32_t t = h;
+        h = g; g = f; f = e; e = d; d = c; c = b; b = a; a = t;
+    }
+#else
+    // Eight rounds per iteration, so that the variables never have to move.
+    for (unsigned i = 0; i < 64; i += 8) {
+        sha256Round(a, b, c, d, e, f, g, h, w, i);
+        sha256Round(h, a, b, c, d, e, f, g, w, i + 1);
+        sha256Round(g, h, a, b, c, d, e, f, w, i + 2);
+        sha256Round(f, g, h, a, b, c, d, e, w, i + 3);
+        sha256Round(e, f, g, h, a, b, c, d, w, i + 4);
+        sha256Round(d, e, f, g, h, a, b, c, w, i + 5);
+        sha256Round(c, d, e, f, g, h, a, b, w, i + 6);
+        sha256Round(b, c, d, e, f, g, h, a, w, i + 7);
+    }
+#endif
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+/**
+ * Set \c n bytes to zero through a \c volatile pointer, so that the
+ * stores aren't optimized away even though the bytes are never read again.
+ */
+inline void secureZero(void *p, size_t n) {
+    volatile unsigned char *v = (volatile unsigned char *) p;
+    for (size_t i = 0; i < n; ++i) {
+        v[i] = 0;
+    }
+}
+
+} // namespace detail
+
+/**
+ * \brief Compare two byte slices in time that doesn't depend on where
+ * they differ.
+ *
+ * Use this to check MACs, so that an attacker can't find the right value a
+ * byte at a time by timing how long the comparison takes.
+ *
+ * \return \c true iff the slices are equal.
+ */
+template<size_t L>
+bool equalConstantTime(CByteSlice<L> a, CByteSlice<L> b) {
+    volatile unsigned char diff = 0;
+    for (size_t i = 0; i < L; ++i) {
+        diff = (unsigned char) (diff | (a[i] ^ b[i]));
+    }
+    return diff == 0;
+}
+
+class HmacSha256;
+
+/**
+ * \brief A SHA-256 hash that's computed as the data arrives.
+ *
+ * Full 64-byte blocks are hashed straight from the slices passed to
+ * \c update(); only partial blocks are buffered, in a \c ByteArray<64>
+ * inside the object, so the object needs no memory besides itself.
+ *
+ * \code
+ * safearray::Sha256 sha;
+ * sha.update(header.cslice());
+ * sha.update(&payload);
+ * safearray::ByteArray<32> digest = {};
+ * sha.finish(digest.slice());
+ * \endcode
+ */
+class Sha256 : public Checksum<Sha256>
+{
+public:
+    /**
+     * \brief Start a new hash.
+     */
+    Sha256() : _state{}, _block{}, _length(0) {
+        this->reset();
+    }
+
+    /**
+     * \brief Start over.
+     */
+    void reset() {
+        static const uint32_t init[8] = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+            0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+        };
+        memcpy(this->_state.data(), init, sizeof(init));
+        this->_length = 0;
+    }
+
+    /**
+     * \brief Finish the hash and start a new one.
+     *
+     * \param digest Set to the hash of the bytes added since the last reset.
+     */
+    void finish(ByteSlice<32> digest) {
+        // A 1 bit, then 0 bits up to 8 bytes before the end of a block, then
+        // the length in bits.
+        uint64_t bits = this->_length * 8;
+        size_t used = (size_t) (this->_length % 64);
+        size_t padSize = used < 56 ? 56 - used : 120 - used;
+        ByteArray<72> pad = {};
+        pad[0] = 0x80;
+        for (size_t i = 0; i < 8; ++i) {
+            pad[padSize + i] = (unsigned char) (bits >> (56 - 8 * i));
+        }
+        this->update(CByteArrayPtr(pad.cdata(), padSize + 8));
+        for (size_t i = 0; i < 8; ++i) {
+            detail::storeBigEndian32(digest.data() + 4 * i, this->_state[i]);
+        }
+        this->reset();
+    }
+
+    /**
+     * \copydoc Sha256::finish
+     */
+    void finish(ByteArray<32>& digest) {
+        this->finish(digest.slice());
+    }
+
+    /**
+     * \brief The kernel behind the methods of \c Checksum.
+     *
+     * The bytes are copied first if \c Copy, since hashing works on whole
+     * blocks.
+     */
+    template<bool Copy>
+    void process(unsigned char *dest, const unsigned char *src, size_t n) {
+        if (Copy) {
+            memcpy(dest, src, n);
+        }
+        size_t used = (size_t) (this->_length % 64);
+        this->_length += n;
+        if (used > 0) {
+            size_t take = 64 - used < n ? 64 - used : n;
+            memcpy(this->_block.data() + used, src, take);
+            src += take;
+            n -= take;
+            if (used + take < 64) {
+                return;
+            }
+            detail::sha256Compress(this->_state.data(), this->_block.cdata());
+        }
+        for (; n >= 64; n -= 64, src += 64) {
+            detail::sha256Compress(this->_state.data(), src);
+        }
+        memcpy(this->_block.data(), src, n);
+    }
+
+private:
+    friend class HmacSha256;
+
+    Array<uint32_t, 8> _state;
+    ByteArray<64> _block;
+    uint64_t _length;
+};
+
+/**
+ * \brief An HMAC-SHA256 that's computed as the data arrives.
+ *
+ * The key is only needed by the constructor: the hash states after the
+ * inner and outer key blocks are kept, so \c reset() doesn't need the key
+ * and starting a new message costs no extra blocks.
+ *
+ * \code
+ * safearray::HmacSha256 hmac(key.cslice());
+ * hmac.update(msg.cslice<0, 32>());
+ * if (!hmac.verify(msg.cslice<32, 64>())) {
+ *     return;  // forged or corrupted
+ * }
+ * \endcode
+ */
+class HmacSha256 : public Checksum<HmacSha256>
+{
+public:
+    /**
+     * \brief Start a new HMAC with the given key.
+     */
+    template<size_t L>
+    explicit HmacSha256(CByteSlice<L> key)
+        : _inner(), _outer(), _innerStart{}, _outerStart{} {
+        this->setKey(key.cdata(), L);
+    }
+
+    /**
+     * \brief Start a new HMAC with a key whose size is known only at
+     * runtime.
+     */
+    explicit HmacSha256(CByteArrayPtr key)
+        : _inner(), _outer(), _innerStart{}, _outerStart{} {
+        this->setKey(key.data(), key.size());
+    }
+
+    /**
+     * \brief Start over with the same key.
+     */
+    void reset() {
+        restart(this->_inner, this->_innerStart);
+    }
+
+    /**
+     * \brief Finish the HMAC and start a new one with the same key.
+     *
+     * \param mac Set to the HMAC of the bytes added since the last reset.
+     */
+    void finish(ByteSlice<32> mac) {
+        ByteArray<32> innerHash = {};
+        this->_inner.finish(innerHash);
+        restart(this->_outer, this->_outerStart);
+        this->_outer.update(innerHash.cslice());
+        this->_outer.finish(mac);
+        this->reset();
+    }
+
+    /**
+     * \copydoc HmacSha256::finish
+     */
+    void finish(ByteArray<32>& mac) {
+        this->finish(mac.slice());
+    }
+
+    /**
+     * \brief Finish the HMAC, compare it with an expected value in
+     * constant time, and start a new one with the same key.
+     *
+     * \param mac The expected HMAC, or its first \c L bytes if truncated.
+     * \c L is statically checked to be \c <= \c 32.
+     *
+     * \return \c true iff the HMAC matches.
+     */
+    template<size_t L>
+    bool verify(CByteSlice<L> mac) {
+        static_assert(L > 0 && L <= 32, "Bad MAC length");
+        ByteArray<32> actual = {};
+        this->finish(actual);
+        return equalConstantTime(actual.template cslice<0, L>(), mac);
+    }
+
+    /**
+     * \copydoc Sha256::process
+     */
+    template<bool Copy>
+    void process(unsigned char *dest, const unsigned char *src, size_t n) {
+        this->_inner.process<Copy>(dest, src, n);
+    }
+
+private:
+    void setKey(const unsigned char *key, size_t size) {
+        ByteArray<64> pad = {};
+        if (size > 64) {
+            this->_inner.update(CByteArrayPtr(key, size));
+            this->_inner.finish(pad.slice<0, 32>());
+            // The end of the key is still buffered.
+            detail::secureZero(this->_inner._block.data(), sizeof(this->_inner._block));
+        } else {
+            memcpy(pad.data(), key, size);
+        }
+        for (size_t i = 0; i < 64; ++i) {
+            pad[i] ^= 0x36;
+        }
+        this->_inner.update(pad.cslice());
+        this->_innerStart.assign(this->_inner._state.cslice());
+        for (size_t i = 0; i < 64; ++i) {
+            pad[i] ^= 0x36 ^ 0x5c;
+        }
+        this->_outer.update(pad.cslice());
+        this->_outerStart.assign(this->_outer._state.cslice());
+        detail::secureZero(pad.data(), sizeof(pad));
+    }
+
+    static void restart(Sha256& sha, const Array<uint32_t, 8>& start) {
+        sha._state.assign(start.cslice());
+        sha._length = 64;
+    }
+
+    Sha256 _inner;
+    Sha256 _outer;
+    Array<uint32_t, 8> _innerStart;
+    Array<uint32_t, 8> _outerStart;
+};
+
+} // namespace safearray
+
+#endif
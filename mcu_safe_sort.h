@@ -0,0 +1,487 @@
+#ifndef __MCU_SAFE_SORT_H__
+#define __MCU_SAFE_SORT_H__
+
+/**
+ * \file
+ *
+ * In-place sorting and selection: sorting networks generated at
+ * compile-time for short slices, and introsort (or introselect) for long
+ * ones.  None of them allocate.
+ */
+
+#include "mcu_safe_array.h"
+
+namespace safearray {
+
+namespace detail {
+
+/**
+ * Slices up to this long are sorted by a network.  Batcher's network for
+ * 32 elements has 191 compare-exchanges.
+ */
+const size_t SORT_NETWORK_MAX_SIZE = 32;
+
+/**
+ * Introsort leaves runs this short to insertion sort.
+ */
+const size_t SORT_INSERTION_MAX_SIZE = 16;
+
+/**
+ * The default comparison, \c a \c < \c b.
+ */
+struct Less {
+    template<typename T>
+    bool operator()(const T& a, const T& b) const {
+        return a < b;
+    }
+};
+
+/**
+ * Put \c a and \c b in order by selecting, not branching, so that it
+ * compiles to conditional moves (or min/max) where the CPU has them.
+ */
+template<typename T, typename Compare>
+inline void compareExchange(T& a, T& b, Compare& less) {
+    T x = a;
+    T y = b;
+    bool swap = less(y, x);
+    a = swap ? y : x;
+    b = swap ? x : y;
+}
+
+/**
+ * A compare-exchange of elements \c I and \c J of an \c L -element network.
+ * Batcher's networks are built for a power of two, and the elements past
+ * \c L are treated as larger than everything, so compare-exchanges that
+ * touch them are dropped.
+ */
+template<size_t I, size_t J, size_t L, bool Active = (J < L)>
+struct NetworkStep {
+    template<typename T, typename Compare>
+    static void apply(T *a, Compare& less) {
+        compareExchange(a[I], a[J], less);
+    }
+};
+
+template<size_t I, size_t J, size_t L>
+struct NetworkStep<I, J, L, false> {
+    template<typename T, typename Compare>
+    static void apply(T *, Compare&) {}
+};
+
+/**
+ * The compare-exchanges of \c (I, I + R) for \c I from \c Begin up to (but
+ * not including) \c End, stepping by \c 2R.
+ */
+template<size_t Begin, size_t End, size_t R, size_t L, bool More = (Begin < End)>
+struct NetworkStrided {
+    template<typename T, typename Compare>
+    static void apply(T *a, Compare& less) {
+        NetworkStep<Begin, Begin + R, L>::apply(a, less);
+        NetworkStrided<Begin + 2 * R, End, R, L>::apply(a, less);
+    }
+};
+
+template<size_t Begin, size_t End, size_t R, size_t L>
+struct NetworkStrided<Begin, End, R, L, false> {
+    template<typename T, typename Compare>
+    static void apply(T *, Compare&) {}
+};
+
+/**
+ * Batcher's odd-even merge of the elements \c Lo, \c Lo + R, ... up to
+ * \c Hi (inclusive), whose two halves are sorted.
+ */
+template<size_t Lo, size_t Hi, size_t R, size_t L, bool Split = (2 * R < Hi - Lo)>
+struct NetworkMerge {
+    template<typename T, typename Compare>
+    static void apply(T *a, Compare& less) {
+        NetworkMerge<Lo, Hi, 2 * R, L>::apply(a, less);
+        NetworkMerge<Lo + R, Hi, 2 * R, L>::apply(a, less);
+        NetworkStrided<Lo + R, Hi - R, R, L>::apply(a, less);
+    }
+};
+
+template<size_t Lo, size_t Hi, size_t R, size_t L>
+struct NetworkMerge<Lo, Hi, R, L, false> {
+    template<typename T, typename Compare>
+    static void apply(T *a, Compare& less) {
+        NetworkStep<Lo, Lo + R, L>::apply(a, less);
+    }
+};
+
+/**
+ * Batcher's odd-even merge sort of the elements \c Lo to \c Hi (inclusive),
+ * a power of two of them.
+ */
+template<size_t Lo, size_t Hi, size_t L, bool Split = (Hi > Lo) && (Lo < L)>
+struct NetworkSort {
+    template<typename T, typename Compare>
+    static void apply(T *a, Compare& less) {
+        NetworkSort<Lo, Lo + (Hi - Lo) / 2, L>::apply(a, less);
+        NetworkSort<Lo + (Hi - Lo) / 2 + 1, Hi, L>::apply(a, less);
+        NetworkMerge<Lo, Hi, 1, L>::apply(a, less);
+    }
+};
+
+template<size_t Lo, size_t Hi, size_t L>
+struct NetworkSort<Lo, Hi, L, false> {
+    template<typename T, typename Compare>
+    static void apply(T *, Compare&) {}
+};
+
+constexpr size_t nextPowerOfTwo(size_t n, size_t p = 1) {
+    return p >= n ? p : nextPowerOfTwo(n, 2 * p);
+}
+
+template<typename T>
+inline void swapElems(T& a, T& b) {
+    T tmp = a;
+    a = b;
+    b = tmp;
+}
+
+template<typename T, typename Compare>
+void insertionSort(T *a, size_t n, Compare& less) {
+    for (size_t i = 1; i < n; ++i) {
+        T v = a[i];
+        size_t j = i;
+        for (; j > 0 && less(v, a[j - 1]); --j) {
+            a[j] = a[j - 1];
+        }
+        a[j] = v;
+    }
+}
+
+template<typename T, typename Compare>
+void siftDown(T *a, size_t root, size_t n, Compare& less) {
+    for (;;) {
+        size_t child = 2 * root + 1;
+        if (child >= n) {
+            return;
+        }
+        if (child + 1 < n && less(a[child], a[child + 1])) {
+            ++child;
+        }
+        if (!less(a[root], a[child])) {
+            return;
+        }
+        swapElems(a[root], a[child]);
+        root = child;
+    }
+}
+
+template<typename T, typename Compare>
+void heapSort(T *a, size_t n, Compare& less) {
+    for (size_t i = n / 2; i-- > 0;) {
+        siftDown(a, i, n, less);
+    }
+    for (size_t i = n; i-- > 1;) {
+        swapElems(a[0], a[i]);
+        siftDown(a, 0, i, less);
+    }
+}
+
+/**
+ * Partition around the median of the first, middle and last elements.
+ *
+ * \return The index of the pivot, which is in its final place.
+ */
+template<typename T, typename Compare>
+size_t partition(T *a, size_t n, Compare& less) {
+    size_t mid = n / 2;
+    compareExchange(a[0], a[mid], less);
+    compareExchange(a[mid], a[n - 1], less);
+    compareExchange(a[0], a[mid], less);
+    // a[0] <= pivot <= a[n - 1] act as sentinels, so the scans need no
+    // bounds checks.
+    swapElems(a[mid], a[n - 2]);
+    const T pivot = a[n - 2];
+    size_t i = 0;
+    size_t j = n - 2;
+    for (;;) {
+        while (less(a[++i], pivot)) {}
+        while (less(pivot, a[--j])) {}
+        if (i >= j) {
+            break;
+        }
+        swapElems(a[i], a[j]);
+    }
+    swapElems(a[i], a[n - 2]);
+    return i;
+}
+
+/**
+ * Quicksort that switches to heapsort after \c depth bad splits, and to
+ * insertion sort for short runs.  It recurses into the shorter side only,
+ * so the stack holds at most \c log2(n) frames.
+ */
+template<typename T, typename Compare>
+void introSort(T *a, size_t n, size_t depth, Compare& less) {
+    while (n > SORT_INSERTION_MAX_SIZE) {
+        if (depth == 0) {
+            heapSort(a, n, less);
+            return;
+        }
+        --depth;
+        size_t p = partition(a, n, less);
+        if (p < n - p - 1) {
+            introSort(a, p, depth, less);
+            a += p + 1;
+            n -= p + 1;
+        } else {
+            introSort(a + p + 1, n - p - 1, depth, less);
+            n = p;
+        }
+    }
+    insertionSort(a, n, less);
+}
+
+inline size_t introSortDepth(size_t n) {
+    size_t depth = 0;
+    for (; n > 1; n >>= 1) {
+        depth += 2;
+    }
+    return depth;
+}
+
+/**
+ * Like \c introSort, but only the side holding index \c k is followed, so
+ * it takes linear time on average.
+ */
+template<typename T, typename Compare>
+void introSelect(T *a, size_t n, size_t k, size_t depth, Compare& less) {
+    while (n > SORT_INSERTION_MAX_SIZE) {
+        if (depth == 0) {
+            heapSort(a, n, less);
+            return;
+        }
+        --depth;
+        size_t p = partition(a, n, less);
+        if (k == p) {
+            return;
+        }
+        if (k < p) {
+            n = p;
+        } else {
+            a += p + 1;
+            n -= p + 1;
+            k -= p + 1;
+        }
+    }
+    insertionSort(a, n, less);
+}
+
+template<typename T, size_t L, bool Network = (L <= SORT_NETWORK_MAX_SIZE)>
+struct Sorter {
+    template<typename Compare>
+    static void apply(T *a, Compare& less) {
+        NetworkSort<0, nextPowerOfTwo(L) - 1, L>::apply(a, less);
+    }
+
+    /**
+     * A short slice is sorted outright, since the network has no branches
+     * to mispredict.
+     */
+    template<size_t K, typename Compare>
+    static void select(T *a, Compare& less) {
+        apply(a, less);
+    }
+};
+
+template<typename T, size_t L>
+struct Sorter<T, L, false> {
+    template<typename Compare>
+    static void apply(T *a, Compare& less) {
+        introSort(a, L, introSortDepth(L), less);
+    }
+
+    template<size_t K, typename Compare>
+    static void select(T *a, Compare& less) {
+        introSelect(a, L, K, introSortDepth(L), less);
+    }
+};
+
+} // namespace detail
+
+/**
+ * \brief Sort a slice in place.
+ *
+ * Slices of up to 32 elements are sorted by a Batcher odd-even merge
+ * network that's generated and unrolled at compile-time, with a
+ * branch-free compare-exchange for each step.  Longer ones are sorted by
+ * introsort, which needs no heap and \c O(log \c L) stack.  Neither is
+ * stable.
+ *
+ * \param s The slice to sort.
+ * \param less A function (or function object) that returns \c true iff its
+ * first argument should come before its second.  Default: \c operator<.
+ *
+ * \code
+ * safearray::Array<int16_t, 9> window;
+ * ...
+ * safearray::sort(window);
+ * int16_t median = window[4];
+ * \endcode
+ */
+template<typename T, size_t L, typename Compare>
+void sort(Slice<T, L> s, Compare less) {
+    detail::Sorter<T, L>::apply(s.data(), less);
+}
+
+/**
+ * \brief Sort an empty slice, which does nothing.
+ */
+template<typename T, typename Compare>
+void sort(Slice<T, 0>, Compare) {}
+
+/**
+ * \copydoc sort(Slice<T, L>, Compare)
+ */
+template<typename T, size_t L>
+void sort(Slice<T, L> s) {
+    sort(s, detail::Less());
+}
+
+/**
+ * \copydoc sort(Slice<T, L>, Compare)
+ */
+template<typename T, size_t L, typename Compare>
+void sort(Array<T, L>& a, Compare less) {
+    sort(a.slice(), less);
+}
+
+/**
+ * \copydoc sort(Slice<T, L>, Compare)
+ */
+template<typename T, size_t L>
+void sort(Array<T, L>& a) {
+    sort(a.slice(), detail::Less());
+}
+
+/**
+ * \brief Check whether a slice is sorted.
+ */
+template<typename T, size_t L, typename Compare>
+bool isSorted(CSlice<T, L> s, Compare less) {
+    const T *a = s.cdata();
+    for (size_t i = 1; i < L; ++i) {
+        if (less(a[i], a[i - 1])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * \brief Check whether an empty slice is sorted, which it is.
+ */
+template<typename T, typename Compare>
+bool isSorted(CSlice<T, 0>, Compare) {
+    return true;
+}
+
+/**
+ * \copydoc isSorted(CSlice<T, L>, Compare)
+ */
+template<typename T, size_t L>
+bool isSorted(CSlice<T, L> s) {
+    return isSorted(s, detail::Less());
+}
+
+/**
+ * \brief Partially sort a slice, so that the element at index \c K is the
+ * one that would be there if it were sorted, with none after it that should
+ * come before it, and none before it that should come after it.
+ *
+ * \tparam K The index.  It's statically checked to be less than \c L.
+ * \param s The slice to rearrange.
+ * \param less A function (or function object) that returns \c true iff its
+ * first argument should come before its second.  Default: \c operator<.
+ *
+ * Slices of up to 32 elements are sorted by \c sort's network.  Longer ones
+ * are partitioned by introselect, which takes linear time on average.
+ *
+ * \return A reference to the element at index \c K.
+ */
+template<size_t K, typename T, size_t L, typename Compare>
+T& nthElement(Slice<T, L> s, Compare less) {
+    static_assert(K < L, "Bad index");
+    detail::Sorter<T, L>::template select<K>(s.data(), less);
+    return s.data()[K];
+}
+
+/**
+ * \copydoc nthElement(Slice<T, L>, Compare)
+ */
+template<size_t K, typename T, size_t L>
+T& nthElement(Slice<T, L> s) {
+    return nthElement<K>(s, detail::Less());
+}
+
+/**
+ * \copydoc nthElement(Slice<T, L>, Compare)
+ */
+template<size_t K, typename T, size_t L, typename Compare>
+T& nthElement(Array<T, L>& a, Compare less) {
+    return nthElement<K>(a.slice(), less);
+}
+
+/**
+ * \copydoc nthElement(Slice<T, L>, Compare)
+ */
+template<size_t K, typename T, size_t L>
+T& nthElement(Array<T, L>& a) {
+    return nthElement<K>(a.slice(), detail::Less());
+}
+
+/**
+ * \brief Find the \c P th percentile of a slice (by the nearest rank),
+ * partially sorting it as \c nthElement does.
+ *
+ * \tparam P The percentile.  It's statically checked to be at most \c 100.
+ *
+ * \return A reference to the element at index \c (L-1)*P/100, rounded to
+ * the nearest.
+ */
+template<unsigned P, typename T, size_t L>
+T& percentile(Slice<T, L> s) {
+    static_assert(P <= 100, "Bad percentile");
+    return nthElement<((L - 1) * P + 50) / 100>(s);
+}
+
+/**
+ * \copydoc percentile(Slice<T, L>)
+ */
+template<unsigned P, typename T, size_t L>
+T& percentile(Array<T, L>& a) {
+    return percentile<P>(a.slice());
+}
+
+/**
+ * \brief Find the median of a slice, partially sorting it as
+ * \c nthElement does.  If \c L is even, it's the lower of the two middle
+ * elements.
+ *
+ * \code
+ * safearray::Array<int16_t, 9> window;
+ * ...
+ * int16_t m = safearray::median(window);
+ * \endcode
+ */
+template<typename T, size_t L>
+T& median(Slice<T, L> s) {
+    return nthElement<(L - 1) / 2>(s);
+}
+
+/**
+ * \copydoc median(Slice<T, L>)
+ */
+template<typename T, size_t L>
+T& median(Array<T, L>& a) {
+    return median(a.slice());
+}
+
+} // namespace safearray
+
+#endif
@@ -0,0 +1,335 @@
+#ifndef __MCU_SAFE_STRING_H__
+#define __MCU_SAFE_STRING_H__
+
+/**
+ * \file
+ *
+ * A string with a fixed capacity known at compile-time, along with number
+ * formatting that doesn't need \c printf.
+ */
+
+#include "mcu_safe_array.h"
+
+namespace safearray {
+
+namespace detail {
+
+/**
+ * The unsigned type used to format integers of a given size.  Small types
+ * use \c uint16_t so that 8-bit MCUs don't have to do 32-bit division.
+ */
+template<size_t Size> struct FormatUInt { typedef uint16_t type; };
+template<> struct FormatUInt<4> { typedef uint32_t type; };
+template<> struct FormatUInt<8> { typedef uint64_t type; };
+
+template<typename I>
+constexpr bool isSigned() {
+    return I(-1) < I(0);
+}
+
+template<typename I>
+constexpr I maxValue() {
+    return isSigned<I>()
+        ? I(((I(1) << (sizeof(I) * 8 - 2)) - 1) * 2 + 1)
+        : I(~I(0));
+}
+
+constexpr size_t decimalDigits(uint64_t v) {
+    return v < 10 ? 1 : 1 + decimalDigits(v / 10);
+}
+
+/**
+ * "00", "01", ..., "99", so that integers can be formatted two digits
+ * per division.
+ */
+template<typename Dummy = void>
+struct DigitPairs {
+    static const char table[200];
+};
+
+template<typename Dummy>
+const char DigitPairs<Dummy>::table[200] SAFEARRAY_PROGMEM = {
+    '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+    '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+    '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+    '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+    '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+    '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+    '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+    '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+    '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+    '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9',
+};
+
+/**
+ * Write the decimal digits of \c v so that they end just before \c end.
+ *
+ * \return A pointer to the first digit.
+ */
+template<typename U>
+char *formatDecimal(U v, char *end) {
+    const char *pairs = DigitPairs<>::table;
+    while (v >= 100) {
+        unsigned r = (unsigned) (v % 100) * 2;
+        v /= 100;
+        *--end = (char) SAFEARRAY_READ_PROGMEM_BYTE(pairs + r + 1);
+        *--end = (char) SAFEARRAY_READ_PROGMEM_BYTE(pairs + r);
+    }
+    if (v >= 10) {
+        unsigned r = (unsigned) v * 2;
+        *--end = (char) SAFEARRAY_READ_PROGMEM_BYTE(pairs + r + 1);
+        *--end = (char) SAFEARRAY_READ_PROGMEM_BYTE(pairs + r);
+    } else {
+        *--end = (char) ('0' + v);
+    }
+    return end;
+}
+
+} // namespace detail
+
+/**
+ * \brief The maximum number of characters needed to format an integer
+ * in decimal (including the sign, if any).
+ *
+ * \tparam I An integer type.
+ */
+template<typename I>
+struct MaxDecimalWidth {
+    static constexpr size_t value =
+        detail::decimalDigits((uint64_t) detail::maxValue<I>())
+        + (detail::isSigned<I>() ? 1 : 0);
+};
+
+template<typename I>
+constexpr size_t MaxDecimalWidth<I>::value;
+
+/**
+ * \brief The maximum number of characters needed to format an integer
+ * in hexadecimal (without a prefix).
+ *
+ * \tparam I An integer type.
+ */
+template<typename I>
+struct MaxHexWidth {
+    static constexpr size_t value = sizeof(I) * 2;
+};
+
+template<typename I>
+constexpr size_t MaxHexWidth<I>::value;
+
+/**
+ * \brief A string with a fixed capacity known at compile-time.
+ *
+ * \tparam N The capacity (i.e., the maximum number of characters, not
+ * counting the terminating \c NUL).
+ *
+ * The characters are kept \c NUL-terminated in an \c Array<char, N + 1>.
+ * Appending something that doesn't fit does nothing and returns \c false,
+ * so the string is never truncated in the middle of a value.
+ *
+ * Integers are formatted two digits at a time using a lookup table instead
+ * of \c printf, which saves a lot of flash and time on small MCUs:
+ *
+ * \code
+ * safearray::FixedString<32> line;
+ * line.append("id=");
+ * line.appendInt(msg->my_id);
+ * line.append(" crc=0x");
+ * line.appendHex(crc, safearray::MaxHexWidth<uint16_t>::value);
+ * uart_write(line.c_str(), line.size());
+ * \endcode
+ */
+template<size_t N>
+class FixedString
+{
+public:
+    /**
+     * \brief Make an empty string.
+     */
+    FixedString() : _buf{}, _size(0) {}
+
+    /**
+     * \brief This constructor is deleted to prevent accidental copies.
+     */
+    FixedString(const FixedString& other) = delete;
+
+    /**
+     * \brief This method is deleted to prevent accidental copies.
+     */
+    FixedString& operator=(const FixedString& other) = delete;
+
+    /**
+     * \brief Get the number of characters.
+     *
+     * \return The number of characters, not counting the terminating \c NUL.
+     */
+    size_t size() const {
+        return this->_size;
+    }
+
+    /**
+     * \brief Get the capacity.
+     *
+     * \return \c N
+     */
+    constexpr static size_t capacity() {
+        return N;
+    }
+
+    /**
+     * \return The characters, followed by a \c NUL.
+     */
+    const char *c_str() const {
+        return this->_buf.cdata();
+    }
+
+    /**
+     * \brief Make a pointer to the characters.
+     *
+     * \return A \c CArrayPtr to the characters (not including the \c NUL).
+     */
+    CArrayPtr<char> operator&() const {
+        return CArrayPtr<char>(this->_buf.cdata(), this->_size);
+    }
+
+    /**
+     * \copydoc CSlice::operator[]
+     */
+    char operator[](size_t i) const {
+        return this->_buf[i];
+    }
+
+    /**
+     * \brief Remove all characters.
+     */
+    void clear() {
+        this->_size = 0;
+        this->_buf[0] = '\0';
+    }
+
+    /**
+     * \brief Append a character.
+     *
+     * \return \c false iff the string was full.
+     */
+    bool append(char c) {
+        if (this->_size == N) {
+            return false;
+        }
+        this->_buf[this->_size++] = c;
+        this->_buf[this->_size] = '\0';
+        return true;
+    }
+
+    /**
+     * \brief Append characters from a slice.
+     *
+     * \param data A slice from which to copy characters.  Its size is
+     * statically checked against the capacity.
+     *
+     * \return \c false (and nothing is appended) iff there wasn't enough room.
+     */
+    template<size_t L>
+    bool append(CSlice<char, L> data) {
+        static_assert(L <= N, "Bad slice length");
+        return this->appendChars(data.cdata(), L);
+    }
+
+    /**
+     * \brief Append a string literal.
+     *
+     * \param s A string literal.  Its length is statically checked against
+     * the capacity.
+     *
+     * \return \c false (and nothing is appended) iff there wasn't enough room.
+     */
+    template<size_t L>
+    bool append(const char (&s)[L]) {
+        static_assert(L - 1 <= N, "Bad string length");
+        return this->appendChars(s, L - 1);
+    }
+
+    /**
+     * \brief Append characters whose number is known only at runtime.
+     *
+     * \return \c false (and nothing is appended) iff there wasn't enough room.
+     */
+    bool append(CArrayPtr<char> data) {
+        return this->appendChars(data.data(), data.size());
+    }
+
+    /**
+     * \brief Append an integer in decimal.
+     *
+     * \tparam I An integer type.  \c MaxDecimalWidth<I> is statically checked
+     * against the capacity.
+     *
+     * \return \c false (and nothing is appended) iff there wasn't enough room.
+     */
+    template<typename I>
+    bool appendInt(I v) {
+        static_assert(MaxDecimalWidth<I>::value <= N, "String too short for integer type");
+        typedef typename detail::FormatUInt<sizeof(I)>::type U;
+        char tmp[MaxDecimalWidth<I>::value];
+        char *end = tmp + sizeof(tmp);
+        bool neg = detail::isSigned<I>() && v < 0;
+        U u = neg ? (U) (U(0) - (U) v) : (U) v;
+        char *p = detail::formatDecimal(u, end);
+        if (neg) {
+            *--p = '-';
+        }
+        return this->appendChars(p, end - p);
+    }
+
+    /**
+     * \brief Append an integer in hexadecimal (lowercase, without a prefix).
+     *
+     * \tparam I An integer type.  \c MaxHexWidth<I> is statically checked
+     * against the capacity.
+     *
+     * \param v The integer.  Negative values are formatted in two's complement.
+     * \param minDigits The output is padded with leading zeros to at least
+     * this many digits (up to \c MaxHexWidth<I>).  Default: \c 1.
+     *
+     * \return \c false (and nothing is appended) iff there wasn't enough room.
+     */
+    template<typename I>
+    bool appendHex(I v, size_t minDigits = 1) {
+        static_assert(MaxHexWidth<I>::value <= N, "String too short for integer type");
+        typedef typename detail::FormatUInt<sizeof(I)>::type U;
+        char tmp[MaxHexWidth<I>::value];
+        char *end = tmp + sizeof(tmp);
+        char *p = end;
+        U u = (U) v;
+        if (sizeof(I) == 1) {
+            u &= 0xff;
+        }
+        do {
+            unsigned d = (unsigned) (u & 0xf);
+            *--p = (char) (d < 10 ? '0' + d : 'a' + d - 10);
+            u >>= 4;
+        } while (u != 0);
+        while ((size_t) (end - p) < minDigits && p > tmp) {
+            *--p = '0';
+        }
+        return this->appendChars(p, end - p);
+    }
+
+private:
+    bool appendChars(const char *s, size_t n) {
+        if (n > N - this->_size) {
+            return false;
+        }
+        memcpy(this->_buf.data() + this->_size, s, n);
+        this->_size += n;
+        this->_buf[this->_size] = '\0';
+        return true;
+    }
+
+    Array<char, N + 1> _buf;
+    size_t _size;
+};
+
+} // namespace safearray
+
+#endif
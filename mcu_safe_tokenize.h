@@ -0,0 +1,187 @@
+#ifndef __MCU_SAFE_TOKENIZE_H__
+#define __MCU_SAFE_TOKENIZE_H__
+
+/**
+ * \file
+ *
+ * Splitting text (e.g., AT commands or lines of CSV) into fields that point
+ * into the original buffer, so nothing is copied.
+ */
+
+#include "mcu_safe_search.h"
+#include "mcu_safe_vector.h"
+
+namespace safearray {
+
+/**
+ * \brief A lazy iterator over the fields of a C array of bytes (or
+ * \c chars), separated by any of a few delimiters.
+ *
+ * \tparam T A byte-sized type, e.g., \c char or \c unsigned \c char.
+ * \tparam K The number of delimiters.
+ *
+ * The fields are pointers into the array, so it (and the delimiters) must
+ * outlive them.
+ *
+ * \code
+ * static const safearray::Array<char, 2> DELIMS = {{',', '='}};
+ *
+ * safearray::Tokenizer<char, 2> fields(&line, DELIMS.cslice());
+ * while (fields.hasNext()) {
+ *     safearray::CArrayPtr<char> field = fields.next();
+ *     ...
+ * }
+ * \endcode
+ */
+template<typename T, size_t K>
+class Tokenizer
+{
+public:
+    static_assert(sizeof(T) == 1, "Bad element type");
+    static_assert(K > 0, "No delimiters");
+
+    /**
+     * \brief Make a tokenizer.
+     *
+     * \param s The array to split.
+     * \param delims The elements that separate fields.
+     * \param skipEmpty If \c true, runs of delimiters count as one, and
+     * leading and trailing delimiters are ignored, e.g., for splitting words
+     * separated by spaces.  If \c false, every delimiter ends a field, even
+     * an empty one, as in CSV.
+     */
+    Tokenizer(CArrayPtr<T> s, CSlice<T, K> delims, bool skipEmpty = false)
+        : _data(s.data()), _size(s.size()), _pos(0), _delims(delims),
+          _skipEmpty(skipEmpty), _done(false) {
+        this->skipDelimiters();
+    }
+
+    /**
+     * \copydoc Tokenizer(CArrayPtr<T>, CSlice<T, K>, bool)
+     */
+    template<size_t L>
+    Tokenizer(CSlice<T, L> s, CSlice<T, K> delims, bool skipEmpty = false)
+        : Tokenizer(CArrayPtr<T>(s.cdata(), L), delims, skipEmpty) {}
+
+    /**
+     * \brief Check whether there are any fields left.
+     */
+    bool hasNext() const {
+        return !this->_done;
+    }
+
+    /**
+     * \brief Get the next field, and move past it and the delimiter after
+     * it.
+     *
+     * \return The field, or an empty pointer to the end of the array if
+     * there are no fields left.
+     */
+    CArrayPtr<T> next() {
+        if (this->_done) {
+            return CArrayPtr<T>(this->_data + this->_size, 0);
+        }
+        size_t start = this->_pos;
+        size_t n = detail::findAny<K>((const unsigned char *) this->_data + start,
+                                      this->_size - start,
+                                      (const unsigned char *) this->_delims.cdata());
+        if (start + n == this->_size) {
+            this->_pos = this->_size;
+            this->_done = true;
+        } else {
+            this->_pos = start + n + 1;
+            this->skipDelimiters();
+        }
+        return CArrayPtr<T>(this->_data + start, n);
+    }
+
+    /**
+     * \brief Get everything that hasn't been split yet, e.g., the arguments
+     * after an AT command's name.
+     */
+    CArrayPtr<T> rest() const {
+        return CArrayPtr<T>(this->_data + this->_pos, this->_size - this->_pos);
+    }
+
+private:
+    bool isDelimiter(T c) const {
+        for (size_t i = 0; i < K; ++i) {
+            if (c == this->_delims[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void skipDelimiters() {
+        if (!this->_skipEmpty) {
+            return;
+        }
+        while (this->_pos < this->_size && this->isDelimiter(this->_data[this->_pos])) {
+            ++this->_pos;
+        }
+        this->_done = this->_pos == this->_size;
+    }
+
+    const T *_data;
+    size_t _size;
+    size_t _pos;
+    CSlice<T, K> _delims;
+    bool _skipEmpty;
+    bool _done;
+};
+
+/**
+ * \brief Make a \c Tokenizer.
+ *
+ * \copydetails Tokenizer::Tokenizer(CArrayPtr<T>, CSlice<T, K>, bool)
+ */
+template<typename T, size_t K>
+Tokenizer<T, K> tokenize(CArrayPtr<T> s, CSlice<T, K> delims, bool skipEmpty = false) {
+    return Tokenizer<T, K>(s, delims, skipEmpty);
+}
+
+/**
+ * \copydoc tokenize(CArrayPtr<T>, CSlice<T, K>, bool)
+ */
+template<typename T, size_t L, size_t K>
+Tokenizer<T, K> tokenize(CSlice<T, L> s, CSlice<T, K> delims, bool skipEmpty = false) {
+    return Tokenizer<T, K>(s, delims, skipEmpty);
+}
+
+/**
+ * \brief Split a C array of bytes (or \c chars) into at most \c N fields.
+ *
+ * \param s The array to split.
+ * \param delims The elements that separate fields.
+ * \param fields Cleared, then filled with pointers to the fields.
+ * \param skipEmpty See \c Tokenizer::Tokenizer.
+ *
+ * \return \c false iff there were more than \c N fields, in which case
+ * \c fields holds the first \c N.
+ */
+template<typename T, size_t K, size_t N>
+bool split(CArrayPtr<T> s, CSlice<T, K> delims, StaticVector<CArrayPtr<T>, N>& fields,
+           bool skipEmpty = false) {
+    fields.clear();
+    Tokenizer<T, K> tokens(s, delims, skipEmpty);
+    while (tokens.hasNext()) {
+        if (!fields.push_back(tokens.next())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * \copydoc split(CArrayPtr<T>, CSlice<T, K>, StaticVector<CArrayPtr<T>, N>&, bool)
+ */
+template<typename T, size_t L, size_t K, size_t N>
+bool split(CSlice<T, L> s, CSlice<T, K> delims, StaticVector<CArrayPtr<T>, N>& fields,
+           bool skipEmpty = false) {
+    return split(CArrayPtr<T>(s.cdata(), L), delims, fields, skipEmpty);
+}
+
+} // namespace safearray
+
+#endif
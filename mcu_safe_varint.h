@@ -0,0 +1,354 @@
+#ifndef __MCU_SAFE_VARINT_H__
+#define __MCU_SAFE_VARINT_H__
+
+/**
+ * \file
+ *
+ * Variable-length integers (unsigned LEB128, as in Protocol Buffers), with
+ * zig-zag encoding for signed values.
+ */
+
+#include "mcu_safe_string.h"
+
+namespace safearray {
+
+/**
+ * \brief The maximum number of bytes in a varint holding an \c I, e.g.,
+ * \c 5 for \c uint32_t.
+ *
+ * \tparam I An integer type.
+ */
+template<typename I>
+struct VarintMaxSize {
+    static constexpr size_t value = (sizeof(I) * 8 + 6) / 7;
+};
+
+template<typename I>
+constexpr size_t VarintMaxSize<I>::value;
+
+namespace detail {
+
+/**
+ * The unsigned type with the same size as a signed one.
+ */
+template<size_t Size> struct VarintUInt;
+template<> struct VarintUInt<1> { typedef uint8_t type; };
+template<> struct VarintUInt<2> { typedef uint16_t type; };
+template<> struct VarintUInt<4> { typedef uint32_t type; };
+template<> struct VarintUInt<8> { typedef uint64_t type; };
+
+#if !defined(__AVR__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+/**
+ * The word that short varints are decoded from in one go.
+ */
+#if UINTPTR_MAX > 0xffffffffu
+typedef uint64_t VarintWord;
+#else
+typedef uint32_t VarintWord;
+#endif
+
+const VarintWord VARINT_ONES = (VarintWord) -1 / 0xff;
+
+/**
+ * Squeeze out the continuation bits of the (masked) bytes of a varint.
+ */
+inline VarintWord varintCompact(VarintWord x) {
+    const VarintWord ones16 = (VarintWord) -1 / 0xffff;
+    const VarintWord ones32 = (VarintWord) -1 / 0xffffffffu;
+    x &= VARINT_ONES * 0x7f;
+    x = (x & (ones16 * 0x007f)) | ((x >> 1) & (ones16 * 0x3f80));
+    x = (x & (ones32 * 0x3fff)) | ((x >> 2) & (ones32 * 0x0fffc000u));
+    if (sizeof(VarintWord) == 8) {
+        x = (x & 0x0fffffffu) | ((x >> 4) & ((VarintWord) 0x0fffffffu << 28));
+    }
+    return x;
+}
+#endif
+
+} // namespace detail
+
+/**
+ * \brief Get the number of bytes in the varint holding a value.
+ *
+ * \tparam I An unsigned integer type.
+ */
+template<typename I>
+size_t varintSize(I value) {
+    static_assert(!detail::isSigned<I>(), "Integer type is signed");
+    size_t n = 1;
+    while (value >= 0x80) {
+        value = (I) (value >> 7);
+        ++n;
+    }
+    return n;
+}
+
+/**
+ * \brief Map a signed integer to an unsigned one so that values near zero
+ * (including negative ones) have short varints: \c 0, \c -1, \c 1, \c -2
+ * become \c 0, \c 1, \c 2, \c 3.
+ *
+ * \tparam I A signed integer type.
+ */
+template<typename I>
+typename detail::VarintUInt<sizeof(I)>::type zigzagEncode(I value) {
+    static_assert(detail::isSigned<I>(), "Integer type is unsigned");
+    typedef typename detail::VarintUInt<sizeof(I)>::type U;
+    return (U) ((U) ((U) value << 1) ^ (U) (value >> (sizeof(I) * 8 - 1)));
+}
+
+/**
+ * \brief Undo \c zigzagEncode.
+ *
+ * \tparam I The signed integer type that was encoded.
+ */
+template<typename I>
+I zigzagDecode(typename detail::VarintUInt<sizeof(I)>::type value) {
+    static_assert(detail::isSigned<I>(), "Integer type is unsigned");
+    typedef typename detail::VarintUInt<sizeof(I)>::type U;
+    return (I) ((U) (value >> 1) ^ (U) (0 - (U) (value & 1)));
+}
+
+/**
+ * \brief Encode a value as a varint at the start of a slice.
+ *
+ * \tparam I An unsigned integer type.
+ * \param dest Where to put the varint.  Its length is statically checked
+ * against \c VarintMaxSize<I>.
+ *
+ * \return The number of bytes written.
+ */
+template<typename I, size_t M>
+size_t encodeVarint(I value, ByteSlice<M> dest) {
+    static_assert(!detail::isSigned<I>(), "Integer type is signed");
+    static_assert(VarintMaxSize<I>::value <= M, "Destination too short");
+    unsigned char *p = dest.data();
+    while (value >= 0x80) {
+        *p++ = (unsigned char) (value | 0x80);
+        value = (I) (value >> 7);
+    }
+    *p++ = (unsigned char) value;
+    return p - dest.data();
+}
+
+/**
+ * \copydoc encodeVarint(I, ByteSlice<M>)
+ */
+template<typename I, size_t M>
+size_t encodeVarint(I value, ByteArray<M>& dest) {
+    return encodeVarint(value, dest.slice());
+}
+
+/**
+ * \brief Writes varints one after another into a byte slice.
+ *
+ * \tparam L The number of bytes in the slice.
+ *
+ * Room is checked once per value, not once per byte.
+ *
+ * \code
+ * safearray::VarintWriter<sizeof(msg)> w(msg.slice());
+ * if (!w.write(packets) || !w.writeSigned(temperature)) {
+ *     return; // message full
+ * }
+ * send(msg.cdata(), w.size());
+ * \endcode
+ */
+template<size_t L>
+class VarintWriter
+{
+public:
+    /**
+     * \brief Make a writer that starts at the beginning of a slice.
+     */
+    explicit VarintWriter(ByteSlice<L> data) : _data(data), _pos(0) {}
+
+    /**
+     * \brief Write an unsigned value.
+     *
+     * \tparam I An unsigned integer type.
+     *
+     * \return \c false (and nothing is written) iff there isn't room.
+     */
+    template<typename I>
+    bool write(I value) {
+        static_assert(!detail::isSigned<I>(), "Integer type is signed");
+        size_t avail = L - this->_pos;
+        if (avail < VarintMaxSize<I>::value && avail < varintSize(value)) {
+            return false;
+        }
+        unsigned char *p = this->_data.data() + this->_pos;
+        while (value >= 0x80) {
+            *p++ = (unsigned char) (value | 0x80);
+            value = (I) (value >> 7);
+        }
+        *p++ = (unsigned char) value;
+        this->_pos = p - this->_data.data();
+        return true;
+    }
+
+    /**
+     * \brief Write a signed value, zig-zag encoded.
+     *
+     * \tparam I A signed integer type.
+     *
+     * \return \c false (and nothing is written) iff there isn't room.
+     */
+    template<typename I>
+    bool writeSigned(I value) {
+        return this->write(zigzagEncode(value));
+    }
+
+    /**
+     * \brief Get the number of bytes written so far.
+     */
+    size_t size() const {
+        return this->_pos;
+    }
+
+    /**
+     * \brief Get the number of bytes that can still be written.
+     */
+    size_t remaining() const {
+        return L - this->_pos;
+    }
+
+private:
+    ByteSlice<L> _data;
+    size_t _pos;
+};
+
+/**
+ * \brief Reads varints one after another from a byte slice.
+ *
+ * \tparam L The number of bytes in the slice.
+ *
+ * On little-endian CPUs wider than 8 bits, varints that fit in a word
+ * (which covers every \c uint32_t on 64-bit CPUs) are decoded with a
+ * single load and no loop when a word's worth of bytes is left.
+ */
+template<size_t L>
+class VarintReader
+{
+public:
+    /**
+     * \brief Make a reader that starts at the beginning of a slice.
+     */
+    explicit VarintReader(CByteSlice<L> data) : _data(data), _pos(0) {}
+
+    /**
+     * \brief Read an unsigned value.
+     *
+     * \tparam I An unsigned integer type.
+     *
+     * \return \c false (and nothing is consumed) iff the varint runs past
+     * the end of the slice, is longer than \c VarintMaxSize<I>, or doesn't
+     * fit in an \c I.
+     */
+    template<typename I>
+    bool read(I& out) {
+        static_assert(!detail::isSigned<I>(), "Integer type is signed");
+        const size_t M = VarintMaxSize<I>::value;
+        const unsigned char *p = this->_data.cdata() + this->_pos;
+        size_t avail = L - this->_pos;
+#if !defined(__AVR__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        if (avail >= sizeof(detail::VarintWord)) {
+            detail::VarintWord w;
+            memcpy(&w, p, sizeof(w));
+            if ((w & 0x8080) != 0x8080) {
+                // One or two bytes, which is most of them, without branches.
+                unsigned two = (unsigned) (w >> 7) & 1;
+                uint32_t v = ((uint32_t) w & 0x7f) | ((uint32_t) (w >> 1) & (0x3f80 & (0 - two)));
+                if (v > detail::maxValue<I>()) {
+                    return false;
+                }
+                out = (I) v;
+                this->_pos += 1 + two;
+                return true;
+            }
+            detail::VarintWord stops = ~w & (detail::VARINT_ONES * 0x80);
+            if (stops != 0) {
+                size_t n = (size_t) __builtin_ctzll(stops) / 8 + 1;
+                detail::VarintWord v = detail::varintCompact(w & (stops ^ (stops - 1)));
+                if (n > M || v > detail::maxValue<I>()) {
+                    return false;
+                }
+                out = (I) v;
+                this->_pos += n;
+                return true;
+            }
+        }
+#endif
+        I v = 0;
+        for (size_t i = 0; i < M && i < avail; ++i) {
+            unsigned char chunk = p[i] & 0x7f;
+            if (i == M - 1 && (p[i] & 0x80 || chunk >> (sizeof(I) * 8 - 7 * i) != 0)) {
+                return false;
+            }
+            v = (I) (v | (I) chunk << (7 * i));
+            if ((p[i] & 0x80) == 0) {
+                out = v;
+                this->_pos += i + 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * \brief Read a zig-zag encoded signed value.
+     *
+     * \tparam I A signed integer type.
+     *
+     * \return \c false (and nothing is consumed) iff \c read would fail.
+     */
+    template<typename I>
+    bool readSigned(I& out) {
+        typename detail::VarintUInt<sizeof(I)>::type u;
+        if (!this->read(u)) {
+            return false;
+        }
+        out = zigzagDecode<I>(u);
+        return true;
+    }
+
+    /**
+     * \brief Read up to \c N unsigned values.
+     *
+     * \param out Filled with the values, from the start.
+     *
+     * \return The number of values read.  It's less than \c N iff the
+     * slice ran out or the next varint is bad (see \c read).
+     */
+    template<size_t N>
+    size_t readBatch(Slice<uint32_t, N> out) {
+        size_t i = 0;
+        while (i < N && this->read(out[i])) {
+            ++i;
+        }
+        return i;
+    }
+
+    /**
+     * \copydoc readBatch(Slice<uint32_t, N>)
+     */
+    template<size_t N>
+    size_t readBatch(Array<uint32_t, N>& out) {
+        return this->readBatch(out.slice());
+    }
+
+    /**
+     * \brief Get the number of bytes that haven't been read.
+     */
+    size_t remaining() const {
+        return L - this->_pos;
+    }
+
+private:
+    CByteSlice<L> _data;
+    size_t _pos;
+};
+
+} // namespace safearray
+
+#endif
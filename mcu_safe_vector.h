@@ -0,0 +1,501 @@
+#ifndef __MCU_SAFE_VECTOR_H__
+#define __MCU_SAFE_VECTOR_H__
+
+/**
+ * \file
+ *
+ * A variable-length collection with a fixed capacity known at compile-time,
+ * along with the slice types used to view it.
+ */
+
+#include "mcu_safe_array.h"
+
+#ifndef __AVR__
+#include <new>
+#endif
+
+namespace safearray {
+
+namespace detail {
+
+#ifdef __AVR__
+/**
+ * Tag used to select the placement-new overload below, since AVR has no
+ * \c <new>.  It's a distinct type so that the overload can't clash with a
+ * standard library's \c operator \c new(size_t, \c void*).
+ */
+struct PlacementTag {};
+#endif
+
+} // namespace detail
+
+} // namespace safearray
+
+#ifdef __AVR__
+inline void *operator new(size_t, safearray::detail::PlacementTag, void *p) noexcept {
+    return p;
+}
+#endif
+
+namespace safearray {
+
+namespace detail {
+
+template<typename T> struct RemoveReference { typedef T type; };
+template<typename T> struct RemoveReference<T&> { typedef T type; };
+template<typename T> struct RemoveReference<T&&> { typedef T type; };
+
+/**
+ * Equivalent to \c std::move.
+ */
+template<typename T>
+typename RemoveReference<T>::type&& move(T&& v) {
+    return static_cast<typename RemoveReference<T>::type&&>(v);
+}
+
+/**
+ * Equivalent to \c std::forward.
+ */
+template<typename T>
+T&& forward(typename RemoveReference<T>::type& v) {
+    return static_cast<T&&>(v);
+}
+
+/**
+ * Construct a \c T in uninitialized storage.
+ */
+template<typename T, typename... Args>
+void construct(T *p, Args&&... args) {
+#ifdef __AVR__
+    new (PlacementTag(), p) T(detail::forward<Args>(args)...);
+#else
+    ::new ((void *) p) T(detail::forward<Args>(args)...);
+#endif
+}
+
+/**
+ * Copy \c n instances of \c T with a single \c memcpy if \c T allows it,
+ * or else by copy-constructing them one at a time.
+ */
+template<typename T, bool Trivial = __is_trivially_copyable(T)>
+struct UninitializedCopy;
+
+template<typename T>
+struct UninitializedCopy<T, true> {
+    static void copy(T *dest, const T *src, size_t n) {
+        memcpy(dest, src, n * sizeof(T));
+    }
+};
+
+template<typename T>
+struct UninitializedCopy<T, false> {
+    static void copy(T *dest, const T *src, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            construct(dest + i, src[i]);
+        }
+    }
+};
+
+/**
+ * Appends a slice to a \c StaticVector.  An empty slice has no data to
+ * point to, so appending one is a no-op.
+ */
+template<typename T, size_t M>
+struct Appender {
+    static void append(T *dest, CSlice<T, M> src) {
+        UninitializedCopy<T>::copy(dest, src.cdata(), M);
+    }
+};
+
+template<typename T>
+struct Appender<T, 0> {
+    static void append(T *, CSlice<T, 0>) {}
+};
+
+} // namespace detail
+
+/**
+ * \brief A const pointer to a section of a C array, whose length is known
+ * only at runtime but is bounded by a value known at compile-time.
+ *
+ * \tparam T The type of the elements of the slice.
+ * \tparam N The maximum size (i.e., number of instances of \c T) of the
+ * slice.
+ *
+ * This is what \c StaticVector gives out as a view of its elements.
+ */
+template<typename T, size_t N>
+class CBoundedSlice
+{
+public:
+    /**
+     * \brief Make a slice pointing to \c size instances of \c T at the given
+     * location.
+     *
+     * WARNING: This class provides memory-safety only if the given pointer
+     * points to \c size contiguous instances of \c T.
+     *
+     * \param data A pointer to the beginning of the slice's data.
+     * \param size The number of instances of \c T in the slice.  Must
+     * be \c <= \c N.
+     */
+    CBoundedSlice(const T *data, size_t size) : _data(data), _size(size) {}
+
+    /**
+     * \copydoc CSlice::cdata
+     */
+    template<size_t Offset = 0>
+    const T *cdata() const {
+        static_assert(Offset < N, "Bad offset");
+        return this->_data + Offset;
+    }
+
+    /**
+     * \copydoc CSlice::operator[]
+     */
+    const T& operator[](size_t i) const {
+        return this->_data[i];
+    }
+
+    /**
+     * \copydoc CSlice::operator&
+     */
+    CArrayPtr<T> operator&() const {
+        return CArrayPtr<T>(this->_data, this->_size);
+    }
+
+    /**
+     * \brief Get the number of instances of \c T in the slice.
+     *
+     * \return The number of instances of \c T in the slice.
+     */
+    size_t size() const {
+        return this->_size;
+    }
+
+    /**
+     * \brief Get the maximum number of instances of \c T in the slice.
+     *
+     * \return \c N
+     */
+    constexpr static size_t maxSize() {
+        return N;
+    }
+
+protected:
+    const T *_data;
+    size_t _size;
+};
+
+/**
+ * \brief A pointer to a section of a C array, whose length is known
+ * only at runtime but is bounded by a value known at compile-time.
+ *
+ * \tparam T The type of the elements of the slice.
+ * \tparam N The maximum size (i.e., number of instances of \c T) of the
+ * slice.
+ */
+template<typename T, size_t N>
+class BoundedSlice : public CBoundedSlice<T, N>
+{
+public:
+    /**
+     * \copydoc CBoundedSlice::CBoundedSlice
+     */
+    BoundedSlice(T *data, size_t size) : CBoundedSlice<T, N>(data, size) {}
+
+    /**
+     * \copydoc Slice::data
+     */
+    template<size_t Offset = 0>
+    T *data() {
+        return (T *) this->template cdata<Offset>();
+    }
+
+    /**
+     * \copydoc Slice::operator[]
+     */
+    T& operator[](size_t i) {
+        return this->data()[i];
+    }
+
+    /**
+     * \copydoc Slice::fill
+     */
+    void fill(T val) {
+        for (size_t i = 0; i < this->_size; ++i) {
+            (*this)[i] = val;
+        }
+    }
+};
+
+/**
+ * \brief A variable-length collection with a fixed capacity known at
+ * compile-time.
+ *
+ * \tparam T The type of the elements.
+ * \tparam N The capacity (i.e., the maximum number of instances of \c T).
+ *
+ * The elements are stored inside the object, so no heap is used.  Unlike
+ * \c Array, elements are only constructed when they are added, so \c T
+ * needn't be default-constructible.
+ *
+ * Operations that would exceed the capacity (or refer to an element that
+ * doesn't exist) do nothing and return \c false.
+ */
+template<typename T, size_t N>
+class StaticVector
+{
+public:
+    /**
+     * \brief Make an empty vector.
+     */
+    StaticVector() : _size(0) {}
+
+    ~StaticVector() {
+        this->clear();
+    }
+
+    /**
+     * \brief This constructor is deleted to prevent accidental copies.
+     */
+    StaticVector(const StaticVector& other) = delete;
+
+    /**
+     * \brief This method is deleted to prevent accidental copies.
+     */
+    StaticVector& operator=(const StaticVector& other) = delete;
+
+    /**
+     * \brief Get the number of elements.
+     *
+     * \return The number of elements.
+     */
+    size_t size() const {
+        return this->_size;
+    }
+
+    /**
+     * \brief Get the capacity.
+     *
+     * \return \c N
+     */
+    constexpr static size_t capacity() {
+        return N;
+    }
+
+    /**
+     * \return Whether there are no elements.
+     */
+    bool empty() const {
+        return this->_size == 0;
+    }
+
+    /**
+     * \return Whether the vector is at capacity.
+     */
+    bool full() const {
+        return this->_size == N;
+    }
+
+    /**
+     * \brief Get a pointer to the elements.
+     *
+     * \return A pointer to the first element.
+     */
+    const T *cdata() const {
+        return (const T *) this->_storage;
+    }
+
+    /**
+     * \copydoc StaticVector::cdata
+     */
+    T *data() {
+        return (T *) this->_storage;
+    }
+
+    /**
+     * \brief Get the element at a particular index.
+     *
+     * WARNING: This method does no static or runtime bounds-checking.
+     *
+     * \param i An index.  If \c i \c >= \c size(), the return value is
+     * undefined.
+     *
+     * \return A reference to the element at index \c i.
+     */
+    const T& operator[](size_t i) const {
+        return this->cdata()[i];
+    }
+
+    /**
+     * \copydoc StaticVector::operator[](size_t) const
+     */
+    T& operator[](size_t i) {
+        return this->data()[i];
+    }
+
+    /**
+     * \brief Make a pointer to the elements.
+     *
+     * \return A \c CArrayPtr to the elements.
+     */
+    CArrayPtr<T> operator&() const {
+        return CArrayPtr<T>(this->cdata(), this->_size);
+    }
+
+    /**
+     * \brief Make a slice pointing to the elements.
+     *
+     * \return A slice whose size is the current number of elements.
+     */
+    CBoundedSlice<T, N> cslice() const {
+        return CBoundedSlice<T, N>(this->cdata(), this->_size);
+    }
+
+    /**
+     * \copydoc StaticVector::cslice
+     */
+    BoundedSlice<T, N> slice() {
+        return BoundedSlice<T, N>(this->data(), this->_size);
+    }
+
+    /**
+     * \brief Construct an element at the end.
+     *
+     * \param args Arguments for \c T's constructor.
+     *
+     * \return \c false iff the vector was full.
+     */
+    template<typename... Args>
+    bool emplace_back(Args&&... args) {
+        if (this->full()) {
+            return false;
+        }
+        detail::construct(this->data() + this->_size, detail::forward<Args>(args)...);
+        ++this->_size;
+        return true;
+    }
+
+    /**
+     * \brief Copy an element to the end.
+     *
+     * \return \c false iff the vector was full.
+     */
+    bool push_back(const T& val) {
+        return this->emplace_back(val);
+    }
+
+    /**
+     * \brief Move an element to the end.
+     *
+     * \return \c false iff the vector was full.
+     */
+    bool push_back(T&& val) {
+        return this->emplace_back(detail::move(val));
+    }
+
+    /**
+     * \brief Remove the last element.
+     *
+     * \return \c false iff the vector was empty.
+     */
+    bool pop_back() {
+        if (this->empty()) {
+            return false;
+        }
+        --this->_size;
+        this->data()[this->_size].~T();
+        return true;
+    }
+
+    /**
+     * \brief Move an element into the vector at the given index, moving
+     * later elements up by one.
+     *
+     * \param pos The index at which to insert.  Must be \c <= \c size().
+     * \param val The element to insert.
+     *
+     * \return \c false iff the vector was full or \c pos was invalid.
+     */
+    bool insert(size_t pos, T&& val) {
+        if (pos > this->_size || this->full()) {
+            return false;
+        }
+        if (pos == this->_size) {
+            return this->emplace_back(detail::move(val));
+        }
+        T *d = this->data();
+        detail::construct(d + this->_size, detail::move(d[this->_size - 1]));
+        for (size_t i = this->_size - 1; i > pos; --i) {
+            d[i] = detail::move(d[i - 1]);
+        }
+        d[pos] = detail::move(val);
+        ++this->_size;
+        return true;
+    }
+
+    /**
+     * \copydoc StaticVector::insert(size_t, T&&)
+     */
+    bool insert(size_t pos, const T& val) {
+        T tmp(val);
+        return this->insert(pos, detail::move(tmp));
+    }
+
+    /**
+     * \brief Remove the element at the given index, moving later elements
+     * down by one.
+     *
+     * \param pos The index of the element to remove.
+     *
+     * \return \c false iff \c pos was invalid.
+     */
+    bool erase(size_t pos) {
+        if (pos >= this->_size) {
+            return false;
+        }
+        T *d = this->data();
+        for (size_t i = pos + 1; i < this->_size; ++i) {
+            d[i - 1] = detail::move(d[i]);
+        }
+        return this->pop_back();
+    }
+
+    /**
+     * \brief Remove all elements.
+     */
+    void clear() {
+        while (this->pop_back()) {}
+    }
+
+    /**
+     * \brief Copy elements from a slice to the end.
+     *
+     * If \c T is trivially copyable, the elements are copied with a single
+     * \c memcpy.
+     *
+     * \param data A slice from which to copy data.  Its size is statically
+     * checked against the capacity.
+     *
+     * \return \c false (and nothing is copied) iff there wasn't enough room.
+     */
+    template<size_t M>
+    bool append(CSlice<T, M> data) {
+        static_assert(M <= N, "Bad slice length");
+        if (M > N - this->_size) {
+            return false;
+        }
+        detail::Appender<T, M>::append(this->data() + this->_size, data);
+        this->_size += M;
+        return true;
+    }
+
+private:
+    alignas(T) unsigned char _storage[N * sizeof(T)];
+    size_t _size;
+};
+
+} // namespace safearray
+
+#endif
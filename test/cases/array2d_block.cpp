@@ -0,0 +1,2 @@
+Array2D<char, 3, 4> a = {};
+a.block<1, 2, 2, 3>();
\ No newline at end of file
@@ -0,0 +1,3 @@
+Array<char, 10> a = {};
+Array<char, 4> b = {};
+b.assign(a.cstrided<2>());
\ No newline at end of file
@@ -0,0 +1,2 @@
+Array<char, 10> a = {};
+a.copyWithin<5, 0, 6>();
\ No newline at end of file
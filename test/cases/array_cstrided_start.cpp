@@ -0,0 +1,2 @@
+Array<char, 10> a = {};
+a.cstrided<2, 10>();
\ No newline at end of file
@@ -0,0 +1,2 @@
+Array<char, 10> a = {};
+a.shiftLeft<11>();
\ No newline at end of file
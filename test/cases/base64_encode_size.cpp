@@ -0,0 +1,3 @@
+ByteArray<6> mac = {};
+Array<char, 12> text = {};
+base64Encode(mac.cslice(), text);
\ No newline at end of file
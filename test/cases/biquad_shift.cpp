@@ -0,0 +1,2 @@
+Array<BiquadCoeffs<int32_t>, 1> coeffs = {};
+BiquadCascade<int32_t, 1, 17> filter(coeffs);
\ No newline at end of file
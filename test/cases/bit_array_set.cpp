@@ -0,0 +1,3 @@
+#define NUM_BITS 10
+BitArray<NUM_BITS> b;
+b.set<NUM_BITS>();
\ No newline at end of file
@@ -0,0 +1,3 @@
+#define NUM_BITS 10
+BitArray<NUM_BITS> b;
+b.cslice<2, NUM_BITS>().cslice<0, NUM_BITS - 1>();
\ No newline at end of file
@@ -0,0 +1,2 @@
+ByteArray<8> msg = {};
+cborWriter(msg) << CborMapHeader<1>() << "seq" << (uint32_t) 7;
\ No newline at end of file
@@ -0,0 +1,4 @@
+ByteArray<4> frame = {};
+ByteArray<5> payload = {};
+Fletcher16 sum;
+frame << checksummed(payload.cslice(), sum);
\ No newline at end of file
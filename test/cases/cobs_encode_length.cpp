@@ -0,0 +1,3 @@
+ByteArray<300> frame = {};
+ByteArray<301> encoded = {};
+cobsEncode(frame.cslice(), encoded);
\ No newline at end of file
@@ -0,0 +1,3 @@
+ByteArray<4> data = {};
+Crc32::WithPolicy<CrcSliceBy<16> > crc;
+crc.update(data.cslice());
\ No newline at end of file
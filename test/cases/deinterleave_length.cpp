@@ -0,0 +1,4 @@
+Array<int16_t, 20> s = {};
+Array<int16_t, 10> l = {};
+Array<int16_t, 9> r = {};
+deinterleave(s.cslice(), l.slice(), r.slice());
\ No newline at end of file
@@ -0,0 +1,2 @@
+ByteArray<4> rx = {};
+findSequence<0xd3, 0x91, 0xd3, 0x91, 0x00>(rx.cslice());
\ No newline at end of file
@@ -0,0 +1,3 @@
+#define CAPACITY 4
+FixedString<CAPACITY> s;
+s.append("hello");
\ No newline at end of file
@@ -0,0 +1,2 @@
+FixedString<MaxDecimalWidth<int32_t>::value - 1> s;
+s.appendInt((int32_t) 0);
\ No newline at end of file
@@ -0,0 +1,4 @@
+ByteArray<3> h = {};
+ByteArray<4> p = {};
+ByteArray<6> flat = {};
+gather(h.cslice(), p.cslice()).copyTo(flat);
\ No newline at end of file
@@ -0,0 +1,2 @@
+ByteArray<2> a = {};
+getBits<6, 11>(a.cslice());
\ No newline at end of file
@@ -0,0 +1,4 @@
+ByteArray<4> key = {};
+ByteArray<40> mac = {};
+HmacSha256 hmac(key.cslice());
+hmac.verify(mac.cslice<0, 33>());
\ No newline at end of file
@@ -0,0 +1,2 @@
+MedianFilter<int16_t, 5> filter;
+filter.percentile<101>();
\ No newline at end of file
@@ -0,0 +1,3 @@
+Array<int16_t, 8> in = {};
+Array<int16_t, 8> out = {};
+movingAverage<4>(in, out);
\ No newline at end of file
@@ -0,0 +1,2 @@
+Array<int16_t, 9> window = {};
+nthElement<9>(window);
\ No newline at end of file
@@ -0,0 +1,2 @@
+PacketBuffer<4, 16> b;
+b.tx(0).pushHeader<2>().pushHeader<3>();
\ No newline at end of file
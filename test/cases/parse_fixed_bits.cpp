@@ -0,0 +1,3 @@
+Array<char, 4> text = {{'0', '.', '5', '0'}};
+int16_t value;
+parseFixed<16>(text.cslice(), value);
\ No newline at end of file
@@ -0,0 +1,4 @@
+Array<char, 10> a = {};
+Array<char, 4> b = {};
+b.strided<1>().assign(b.slice());
+b.reversed().assign(a.slice());
\ No newline at end of file
@@ -0,0 +1,3 @@
+Array<char, 10> a = {};
+Array<char, 9> b = {};
+a.creversed() == b;
\ No newline at end of file
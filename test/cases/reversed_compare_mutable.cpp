@@ -0,0 +1,5 @@
+Array<char, 10> a = {};
+Array<char, 10> b = {};
+Array<char, 9> c = {};
+a.slice() == b.reversed();
+a.strided<1>() == c.reversed();
\ No newline at end of file
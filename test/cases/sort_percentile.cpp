@@ -0,0 +1,2 @@
+Array<int16_t, 9> window = {};
+percentile<101>(window);
\ No newline at end of file
@@ -0,0 +1,4 @@
+#define CAPACITY 4
+StaticVector<char, CAPACITY> v;
+Array<char, CAPACITY + 1> a = {};
+v.append(a.cslice());
\ No newline at end of file
@@ -0,0 +1,3 @@
+Array<int, 4> values = {};
+Array<int, 1> delims = {{0}};
+tokenize(values.cslice(), delims.cslice());
\ No newline at end of file
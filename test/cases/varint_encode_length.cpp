@@ -0,0 +1,2 @@
+ByteArray<4> dest = {};
+encodeVarint((uint32_t) 300, dest);
\ No newline at end of file
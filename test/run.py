@@ -1,14 +1,15 @@
 import sys
 import os
+import glob
 import subprocess
 import tempfile
 
 PROGAM_PATH = os.path.realpath(__file__)
 CASE_DIR_PATH = os.path.join(os.path.dirname(PROGAM_PATH), 'cases')
-ARRAY_HEADER_PATH = os.path.join(os.path.dirname(PROGAM_PATH), '..', 'mcu_safe_array.h')
+HEADER_DIR_PATH = os.path.join(os.path.dirname(PROGAM_PATH), '..')
 
 SOURCE_TEMPLATE = '''
-#include "{array_h_path}"
+{includes}
 
 using namespace safearray;
 
@@ -18,6 +19,10 @@ int main() {{
 }}
 '''
 
+def get_includes():
+    paths = sorted(glob.glob(os.path.join(HEADER_DIR_PATH, 'mcu_safe_*.h')))
+    return '\n'.join('#include "{}"'.format(p) for p in paths)
+
 def get_case_source(case_name):
     path = os.path.join(CASE_DIR_PATH, case_name + '.cpp')
     with open(path) as f:
@@ -30,7 +35,7 @@ def get_cases():
 
 def run_test(case_name, cc_cmd, tempdir_path):
     # make program
-    source = SOURCE_TEMPLATE.format(array_h_path=ARRAY_HEADER_PATH, \
+    source = SOURCE_TEMPLATE.format(includes=get_includes(), \
         case_source=get_case_source(case_name))
     source_path = os.path.join(tempdir_path, case_name + '.cpp')
     with open(source_path, 'w') as f:
@@ -38,7 +43,7 @@ def run_test(case_name, cc_cmd, tempdir_path):
 
     # run compiler
     cmd = cc_cmd + ['-o', case_name, source_path]
-    proc = subprocess.Popen(cmd, stderr=subprocess.PIPE)
+    proc = subprocess.Popen(cmd, stderr=subprocess.PIPE, universal_newlines=True)
     _, stderr = proc.communicate()
     if proc.returncode == 0:
         print("FAIL: {}: compiled sucessfully".format(case_name))
@@ -47,11 +52,16 @@ def run_test(case_name, cc_cmd, tempdir_path):
         print("FAIL: {}: no static assertion failure".format(case_name))
         print(stderr)
         return False
+    errors = [l for l in stderr.splitlines() if 'error:' in l]
+    if any("static assertion failed" not in l for l in errors):
+        print("FAIL: {}: errors other than static assertion failures".format(case_name))
+        print(stderr)
+        return False
     return True
 
 def main():
     tempdir = tempfile.mkdtemp()
-    cc_cmd = ['avr-g++', '-std=gnu++11']
+    cc_cmd = [os.environ.get('CXX', 'avr-g++'), '-std=gnu++11']
     num_success = 0
     num_fail = 0
     for case_name in get_cases():